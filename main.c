@@ -11,369 +11,4810 @@
 #include <stdio.h>    // for printf, scanf
 #include <stdlib.h>   // for exit( -1)
 #include <string.h>   // for strcpy
+#include <pthread.h>  // for pthread_create, pthread_join
+#include <unistd.h>   // for sysconf
+#include <stdint.h>   // for uint8_t
+#include <limits.h>   // for INT_MIN
+#include <math.h>     // for log2
+#include <time.h>     // for clock_gettime
+#include <fcntl.h>    // for open
+#include <sys/mman.h> // for mmap
+#include <sys/stat.h> // for fstat
+#include <sys/socket.h> // for socket, bind, listen, accept
+#include <sys/un.h>   // for sockaddr_un
+#include <signal.h>   // for signal, SIGPIPE
+#include <errno.h>    // for errno
+#if defined( __x86_64__) || defined( __i386__)
+#include <immintrin.h> // for SSE2 and AVX2 intrinsics
+#define HAVE_X86_SIMD 1
+#endif
 
 // Declare globals
-#define WORD_LENGTH 5     // All words have 5 letters, + 1 NULL at the end when stored
+#define MIN_WORD_LENGTH 4 // Words may have 4 to 8 letters, all words in a run the same length
+#define MAX_WORD_LENGTH 8 // Longest words supported, + 1 NULL at the end when stored
+int WordLength = 5;       // Letters per word, set by the first word read
 #define ANSWERS_FILE_NAME "answersLarge.txt"
 #define GUESSES_FILE_NAME "guessesLarge.txt"
-const int DebugOn = 0;    // Set to 1 to display debug info
+int DebugOn = 0;          // Set to 1, or give --debug, to display debug info
+int ProfileOn = 0;        // Set with --profile to time each phase, see displayProfile(..)
+int NumberOfThreads = 0;  // Threads used for scoring. 0 means use all available cores.
+__thread int TaskThreadCount = 0; // Threads the task running on this thread may use, 0 outside tasks
+#define SCORING_CHUNK_SIZE 64   // Number of words a scoring thread claims at a time
+#define ALPHABET_SIZE 26
+#define PACKED_BLOCK_SIZE 32    // Answers compared at once by the widest (AVX2) kernel
+#define PACKED_NO_LETTER 0xFF   // Packed value for a blanked-out letter or padding
+#define MAX_ANSWER_WEIGHT 255   // Most identical answers one weighted answer stands for
+#define PATTERN_GUESS_TILE 32   // Guesses whose feedback histograms are built together
+#define PATTERN_ANSWER_TILE 1024 // Answers compared against a tile of guesses before moving on
+
+// Ways of computing the scores in findScoresAndTopWords(..).  The first three give identical
+// results.  The last two rank words by the green/yellow/grey feedback they would get instead.
+enum scoringEngines {
+    ENGINE_PACKED,      // SIMD comparison of each guess against the packed answers (default)
+    ENGINE_AGGREGATE,   // Constant time per guess using letter statistics of the answers
+    ENGINE_REFERENCE,   // Original getScore(..), kept to verify the other engines
+    ENGINE_ENTROPY,     // Expected information from the feedback, in thousandths of a bit
+    ENGINE_ELIMINATED   // Expected number of answers ruled out by the feedback, times 1000
+};
+int ScoringEngine = ENGINE_PACKED;   // Engine used for scoring, chosen with --engine
+
+// Optional file caching the score of every guess against every answer, see loadOrBuildScoreMatrix(..)
+#define SCORE_MATRIX_MAGIC "WRDLSCOR"
+#define SCORE_MATRIX_VERSION 1
+char *ScoreMatrixFileName = NULL;   // Set with --cache FILE
+
+// Beam search for the best sequences of opening words, see findAndDisplayBestSequences(..)
+#define MAX_BEAM_DEPTH 8
+int BeamWidth = 10;       // Partial sequences kept at each depth, set with --beam-width N
+int BeamDepth = 3;        // Words per sequence, set with --beam-depth N
+int TopWordsCount = 0;    // With --top N, report the N best words instead of only those tied for best
+long MemoryCap = 0;       // With --mem-cap BYTES, stream the guesses within that much memory, see runStreamingMode(..)
+
+// Non-interactive use, see runBatchMode(..) and runQueryServer(..)
+enum outputFormats {
+    FORMAT_PLAIN,       // Words and scores separated by spaces
+    FORMAT_JSON         // One JSON object per line
+};
+int OutputFormat = FORMAT_PLAIN;   // Set with --format plain|json
+int IsBatchMode = 0;      // Set by --mode or --serve: no menu, and word counts are not displayed
 
 typedef struct wordCount wordCountStruct;
 struct wordCount{
-    char word[ WORD_LENGTH + 1];   // The word length plus NULL
+    char word[ MAX_WORD_LENGTH + 1]; // The word length plus NULL
     int score;                     // Score for the word
+    int wordIndex;                 // Position the word was read into, used as its score matrix row
+};
+
+
+//-----------------------------------------------------------------------------------------
+// Time spent in each phase of the program and counters for the hot paths, collected when
+// ProfileOn is set and displayed at exit.  Phases with the same name are added together.
+#define MAX_PROFILE_PHASES 64
+#define PROFILE_OTHER_PHASES "other phases"   // Phases beyond the first MAX_PROFILE_PHASES - 1
+typedef struct profilePhase profilePhaseStruct;
+struct profilePhase{
+    char name[ 64];         // Name shown in the summary
+    double seconds;         // Total wall time
+    long calls;             // How many times the phase ran
+};
+typedef struct profile profileStruct;
+struct profile{
+    profilePhaseStruct phases[ MAX_PROFILE_PHASES];
+    int phaseCount;         // How many phases have been seen
+    long pairsScored;       // Guess and answer pairs scored by any engine, whether compared or
+                            // added up from the score matrix or the letter statistics
+    long allocations;       // Calls to countedMalloc(..), countedCalloc(..) and countedRealloc(..)
+    long bytesAllocated;    // Bytes requested by those calls
+    long bytesRead;         // Bytes of word files and score matrix files read
+    struct timespec start;  // When the program started
+};
+profileStruct Profile;
+__thread char ProfilePassName[ 64] = "first-word pass";   // Prefix for the phases of findScoresAndTopWords(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Seconds since the given start time.
+double getElapsedSeconds( struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+} //end getElapsedSeconds(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Note the start time of a phase, when profiling.
+void startProfilePhase( struct timespec *start)
+{
+    if( ProfileOn) {
+        clock_gettime( CLOCK_MONOTONIC, start);
+    }
+} //end startProfilePhase(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Add seconds to the named phase, when profiling.  Once MAX_PROFILE_PHASES - 1 phases have
+// been seen any new ones are added up as PROFILE_OTHER_PHASES.
+void addProfilePhase( char name[], double seconds)
+{
+    if( ! ProfileOn) {
+        return;
+    }
+    int index = 0;
+    while( index < Profile.phaseCount && strcmp( Profile.phases[ index].name, name) != 0) {
+        index++;
+    }
+    if( index == Profile.phaseCount) {
+        if( Profile.phaseCount == MAX_PROFILE_PHASES - 1) {
+            name = PROFILE_OTHER_PHASES;
+        }
+        index = 0;
+        while( index < Profile.phaseCount && strcmp( Profile.phases[ index].name, name) != 0) {
+            index++;
+        }
+        if( index == Profile.phaseCount) {
+            snprintf( Profile.phases[ index].name, sizeof( Profile.phases[ index].name), "%s", name);
+            Profile.phaseCount++;
+        }
+    }
+    Profile.phases[ index].seconds += seconds;
+    Profile.phases[ index].calls++;
+} //end addProfilePhase(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Add the time since start to the named phase, when profiling.  Phases inside tasks run at
+// the same time as each other, so they are not recorded; the caller adds up the time of each
+// task once they are all done.
+void endProfilePhase( char name[], struct timespec *start)
+{
+    if( ! ProfileOn || TaskThreadCount > 0) {
+        return;
+    }
+    addProfilePhase( name, getElapsedSeconds( start));
+} //end endProfilePhase(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Add to one of the Profile counters.  Safe to call from the scoring threads.
+void addToProfileCounter( long *counter, long amount)
+{
+    if( ProfileOn) {
+        __atomic_fetch_add( counter, amount, __ATOMIC_RELAXED);
+    }
+} //end addToProfileCounter(..)
+
+
+//-----------------------------------------------------------------------------------------
+// malloc(..), calloc(..) and realloc(..), counted in the Profile.
+void *countedMalloc( size_t size)
+{
+    addToProfileCounter( &Profile.allocations, 1);
+    addToProfileCounter( &Profile.bytesAllocated, (long) size);
+    return malloc( size);
+} //end countedMalloc(..)
+
+void *countedCalloc( size_t count, size_t size)
+{
+    addToProfileCounter( &Profile.allocations, 1);
+    addToProfileCounter( &Profile.bytesAllocated, (long) (count * size));
+    return calloc( count, size);
+} //end countedCalloc(..)
+
+void *countedRealloc( void *memory, size_t size)
+{
+    addToProfileCounter( &Profile.allocations, 1);
+    addToProfileCounter( &Profile.bytesAllocated, (long) size);
+    return realloc( memory, size);
+} //end countedRealloc(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Display the phase times and counters on stderr, so they stay out of the program's results.
+// Registered with atexit(..) by --profile.
+void displayProfile()
+{
+    struct timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now);
+    double totalSeconds = (now.tv_sec - Profile.start.tv_sec) + (now.tv_nsec - Profile.start.tv_nsec) / 1e9;
+
+    if( OutputFormat == FORMAT_JSON) {
+        fprintf( stderr, "{\"profile\":{\"phases\":[");
+        for( int i=0; i<Profile.phaseCount; i++) {
+            fprintf( stderr, "%s{\"name\":\"%s\",\"seconds\":%.6f,\"calls\":%ld}", i > 0 ? "," : "",
+                     Profile.phases[ i].name, Profile.phases[ i].seconds, Profile.phases[ i].calls);
+        }
+        fprintf( stderr, "],\"totalSeconds\":%.6f,\"pairsScored\":%ld,\"allocations\":%ld,"
+                 "\"bytesAllocated\":%ld,\"bytesRead\":%ld}}\n", totalSeconds, Profile.pairsScored,
+                 Profile.allocations, Profile.bytesAllocated, Profile.bytesRead);
+        return;
+    }
+
+    fprintf( stderr, "\nProfile:\n");
+    fprintf( stderr, "  %-48s %12s %8s %6s\n", "Phase", "ms", "calls", "%");
+    for( int i=0; i<Profile.phaseCount; i++) {
+        fprintf( stderr, "  %-48s %12.3f %8ld %6.1f\n", Profile.phases[ i].name, Profile.phases[ i].seconds * 1e3,
+                 Profile.phases[ i].calls, totalSeconds > 0 ? 100.0 * Profile.phases[ i].seconds / totalSeconds : 0.0);
+    }
+    fprintf( stderr, "  %-48s %12.3f\n", "Total", totalSeconds * 1e3);
+    fprintf( stderr, "  Guess-answer pairs scored: %ld\n", Profile.pairsScored);
+    fprintf( stderr, "  Allocations:               %ld (%ld bytes)\n", Profile.allocations, Profile.bytesAllocated);
+    fprintf( stderr, "  Bytes read:                %ld\n", Profile.bytesRead);
+} //end displayProfile(..)
+
+
+//-----------------------------------------------------------------------------------------
+// A words file mapped into memory, so it can be scanned in place without copying it
+// through stdio buffers.  It can be read all at once or a tile of words at a time.
+typedef struct wordFile wordFileStruct;
+struct wordFile{
+    char *fileName;         // Name of the file, used in error messages
+    const char *contents;   // Start of the mapped file contents, or NULL for an empty file
+    size_t size;            // Number of bytes in the file
+    const char *position;   // Where the next word will be read from
+    int lineNumber;         // Lines read so far, used in error messages
+};
+
+
+//-----------------------------------------------------------------------------------------
+// Map a words file into memory.  Exits with an error message if it cannot be opened.
+void mapWordFile( char fileName[], wordFileStruct *file)
+{
+    file->fileName = fileName;
+    file->contents = NULL;
+    file->size = 0;
+    file->position = NULL;
+    file->lineNumber = 0;
+
+    // Ensure file open worked correctly
+    int fileDescriptor = open( fileName, O_RDONLY);
+    struct stat fileStatus;
+    if( fileDescriptor < 0 || fstat( fileDescriptor, &fileStatus) != 0) {
+        printf("Error: could not open %s for reading\n", fileName);
+        exit(-1);    // must include stdlib.h
+    }
+
+    file->size = (size_t) fileStatus.st_size;
+    if( file->size > 0) {
+        void *mapped = mmap( NULL, file->size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+        if( mapped == MAP_FAILED) {
+            printf("Error: could not read %s\n", fileName);
+            exit(-1);
+        }
+        file->contents = (const char *) mapped;
+        file->position = file->contents;
+        madvise( mapped, file->size, MADV_SEQUENTIAL);   // Read ahead, and drop pages once read
+        addToProfileCounter( &Profile.bytesRead, (long) file->size);
+    }
+    close( fileDescriptor);   // The mapping stays valid after closing
+} //end mapWordFile(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Release the mapping of a words file.
+void unmapWordFile( wordFileStruct *file)
+{
+    if( file->contents != NULL) {
+        munmap( (void *) file->contents, file->size);
+    }
+    file->contents = NULL;
+    file->size = 0;
+    file->position = NULL;
+} //end unmapWordFile(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Start reading a words file again from its first line.
+void rewindWordFile( wordFileStruct *file)
+{
+    file->position = file->contents;
+    file->lineNumber = 0;
+} //end rewindWordFile(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Let the system take back the memory of the pages of a words file that have already been
+// read, so streaming through a file bigger than memory only keeps the part being read.
+// The pages are read from the file again if the file is rewound.
+void releaseReadPartOfWordFile( wordFileStruct *file)
+{
+    long pageSize = sysconf( _SC_PAGESIZE);
+    size_t readSize = (size_t) (file->position - file->contents) / pageSize * pageSize;
+    if( file->contents != NULL && readSize > 0) {
+        madvise( (void *) file->contents, readSize, MADV_DONTNEED);
+    }
+} //end releaseReadPartOfWordFile(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Upper bound on the number of words in a file: every word takes at least MIN_WORD_LENGTH
+// letters plus a newline, except possibly the last one.  Used to size the arrays before the
+// words are read.
+int getMaximumWordCount( wordFileStruct *file)
+{
+    return (int) (file->size / (MIN_WORD_LENGTH + 1)) + 1;
+} //end getMaximumWordCount(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Return a pointer to the next newline at or after position, or end if there is none.
+// Checks 16 bytes at a time where SSE2 is available.
+const char *findNextNewline( const char *position, const char *end)
+{
+#ifdef HAVE_X86_SIMD
+    __m128i newlines = _mm_set1_epi8( '\n');
+    while( end - position >= 16) {
+        int mask = _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_loadu_si128( (__m128i *) position), newlines));
+        if( mask != 0) {
+            return position + __builtin_ctz( mask);
+        }
+        position += 16;
+    }
+#endif
+    while( position < end && *position != '\n') {
+        position++;
+    }
+    return position;
+} //end findNextNewline(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Scan a mapped words file line by line from where the last call stopped, storing up to
+// maximumCount words into the array starting at startingIndex with their scores initialized
+// to 0.  Surrounding spaces, tabs and carriage returns and empty lines are ignored.  Every
+// other line must hold exactly one lowercase word of WordLength letters, otherwise the
+// program exits with an error naming the line.
+// If WordLength is 0 the first word sets it, and must have MIN_WORD_LENGTH to MAX_WORD_LENGTH letters.
+// Returns how many words were stored.
+int appendWordsFromFileToArray(
+            wordFileStruct *file,   // Mapped file we'll read from
+            wordCountStruct *words, // Array of words where we'll store words we read from file
+            int startingIndex,      // Starting index into which we will store words.  This is
+                                    // needed when we are appending the guesses words to the
+                                    // array of already stored answer words, giving all words.
+            int maximumCount)       // Most words to read, INT_MAX to read the rest of the file
+{
+    const char *position = file->position;
+    const char *end = file->contents + file->size;
+    int index = startingIndex;
+    int lineNumber = file->lineNumber;
+    while( position < end && index - startingIndex < maximumCount) {
+        const char *lineEnd = findNextNewline( position, end);
+        lineNumber++;
+
+        // Trim surrounding whitespace, including the '\r' of Windows line endings
+        const char *wordStart = position;
+        const char *wordEnd = lineEnd;
+        while( wordStart < wordEnd && (*wordStart == ' ' || *wordStart == '\t' || *wordStart == '\r')) {
+            wordStart++;
+        }
+        while( wordEnd > wordStart && (wordEnd[ -1] == ' ' || wordEnd[ -1] == '\t' || wordEnd[ -1] == '\r')) {
+            wordEnd--;
+        }
+
+        if( wordEnd > wordStart) {
+            int length = (int) (wordEnd - wordStart);
+            if( WordLength == 0 && length >= MIN_WORD_LENGTH && length <= MAX_WORD_LENGTH) {
+                WordLength = length;
+            }
+            int isValid = length == WordLength;
+            for( const char *c = wordStart; isValid && c < wordEnd; c++) {
+                isValid = *c >= 'a' && *c <= 'z';
+            }
+            if( ! isValid && WordLength == 0) {
+                printf("Error: %s line %d: \"%.*s\" is not a lowercase word of %d to %d letters\n",
+                       file->fileName, lineNumber, length > 40 ? 40 : length, wordStart, MIN_WORD_LENGTH, MAX_WORD_LENGTH);
+                exit(-1);
+            }
+            if( ! isValid) {
+                printf("Error: %s line %d: \"%.*s\" is not a %d-letter lowercase word\n",
+                       file->fileName, lineNumber, length > 40 ? 40 : length, wordStart, WordLength);
+                exit(-1);
+            }
+            memcpy( words[ index].word, wordStart, WordLength);
+            words[ index].word[ WordLength] = '\0';
+            words[ index].score = 0;
+            words[ index].wordIndex = index;
+            index++;
+        }
+        position = lineEnd + 1;
+    }
+    file->position = position < end ? position : end;
+    file->lineNumber = lineNumber;
+    return index - startingIndex;
+} //end appendWordsFromFileToArray(..)
+
+
+void selectWordLengthKernels( int wordLength);   // Defined with the kernels below
+
+
+//-----------------------------------------------------------------------------------------
+// Read in words from files into arrays, displaying how many words there are in each file.
+// Each file is mapped and scanned exactly once.  The answers are read straight into the start
+// of allWords and the guesses after them, then answerWords is copied from the front of allWords.
+// The first answer sets WordLength, which every other word must match, and the kernels for
+// that length are chosen.
+void readInWordsAndDisplayNumbers(
+        char answersFileName[],         // Name of the answers file
+        char guessesFileName[],         // Name of the guesses file
+        wordCountStruct * *answerWords, // Array of the answer words, to be allocated
+        int *answersWordCount,          // How many words there are in answerWords
+        wordCountStruct * *allWords,    // Array of all the words, to be allocated
+        int *totalWordCount)            // How many words there are in allWords
+{
+    struct timespec phaseStart;
+    startProfilePhase( &phaseStart);
+    wordFileStruct answersFile;
+    wordFileStruct guessesFile;
+    mapWordFile( answersFileName, &answersFile);
+    mapWordFile( guessesFileName, &guessesFile);
+
+    // Allocate for the most words the files could hold, then read them all.
+    int maximumWordCount = getMaximumWordCount( &answersFile) + getMaximumWordCount( &guessesFile);
+    endProfilePhase( "counting words", &phaseStart);
+    startProfilePhase( &phaseStart);
+    *allWords = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * maximumWordCount);
+    WordLength = 0;
+    *answersWordCount = appendWordsFromFileToArray( &answersFile, *allWords, 0, INT_MAX);
+    int guessesWordCount = appendWordsFromFileToArray( &guessesFile, *allWords, *answersWordCount, INT_MAX);
+    if( ! IsBatchMode) {
+        printf("%s has %d words\n", answersFileName, *answersWordCount);    // Display word counts
+        printf("%s has %d words\n", guessesFileName, guessesWordCount);
+    }
+    unmapWordFile( &answersFile);
+    unmapWordFile( &guessesFile);
+
+    if( *answersWordCount == 0) {
+        printf("Error: %s has no words\n", answersFileName);
+        exit(-1);
+    }
+    selectWordLengthKernels( WordLength);
+
+    // Give back the unused space, and copy the answers out of the front of allWords
+    *totalWordCount = *answersWordCount + guessesWordCount;
+    *allWords = (wordCountStruct *) countedRealloc( *allWords, sizeof( wordCountStruct) * *totalWordCount);
+    *answerWords = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * *answersWordCount);
+    memcpy( *answerWords, *allWords, sizeof( wordCountStruct) * *answersWordCount);
+    endProfilePhase( "loading words", &phaseStart);
+} //end readInWordsAndDisplayNumbers(..)
+
+
+//-----------------------------------------------------------------------------------------
+// The kernels below take the word length as a parameter and are always inlined, so that the
+// instances made for each length by DEFINE_WORD_LENGTH_KERNELS(..) see it as a constant and
+// fully unroll their loops over the letters.  Use them through Kernels, chosen once the
+// words are loaded by selectWordLengthKernels(..).
+#define ALWAYS_INLINE static inline __attribute__(( always_inline))
+
+
+//-----------------------------------------------------------------------------------------
+// Calculate the word comparison score, where it gets:
+//   - One point for each correct letter in an incorrect position
+//   - Three points for each correct letter in the correct position
+ALWAYS_INLINE int compareWordsOfLength( char originalWordParameter[], char comparisonWordParameter[],
+                                        const int wordLength)
+{
+    // Make copies of words, to use in blanking out letters that have already contributed
+    // to scoring.
+    char originalWord[ MAX_WORD_LENGTH + 1];
+    char comparisonWord[ MAX_WORD_LENGTH + 1];
+    memcpy( originalWord, originalWordParameter, wordLength);
+    memcpy( comparisonWord, comparisonWordParameter, wordLength);
+
+    int score = 0;    // Accumulates word score
+
+    // Find exact matches
+    for( int i=0; i<wordLength; i++) {
+        // Accumulate score for exact letter match, and blank out letter so it is
+        // not reused.
+        if( originalWord[ i] == comparisonWord[ i] ) {
+            score += 3;     // Points for a matching letter in the same position
+            originalWord[ i] = ' ';
+            comparisonWord[ i] = ' ';
+        }
+    }
+
+    // Find matching letter in a different position.  Letters that were exact
+    // matches have already been blanked out.
+    for( int i=0; i<wordLength; i++) {
+        char c = originalWord[ i];
+        // Only consider non-blanks
+        if( c != ' ') {
+            // Step through each possible matching character.
+            for( int j=0; j<wordLength; j++) {
+                // Accumulate score for exact letter match, and blank out letter so it is
+                // not reused. After a match is found, break out of comparison loop so that
+                // letter does not count for scoring more than once.
+                if( c == comparisonWord[ j]) {
+                    score += 1;
+                    originalWord[ i] = ' ';
+                    comparisonWord[ j] = ' ';
+                    break;
+                }
+            } //end for( int j ...)
+        } //end if( c...
+    } //end for( int i...
+
+    return score;
+} //end compareWordsOfLength(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Remove from a single answer word the letters that were already handled with the bestWord.
+ALWAYS_INLINE void removeMatchingLettersOfLength(
+        char answerWord[],                // Answer word, letters are blanked out in place
+        char bestWord[ ],                 // The best word
+        const int wordLength)             // Letters in each word
+{
+    // Make a copy of the best word
+    char bestWordCopy[ MAX_WORD_LENGTH + 1];
+    memcpy( bestWordCopy, bestWord, wordLength);
+
+    // First blank out matching letters in the same position.
+    for( int j=0; j<wordLength; j++) {
+        // Compare the bestWord letter[ j] to the answerWord[ j] letter.
+        if( bestWordCopy[ j] == answerWord[ j] ) {
+            // Blank out matching letters, so they can't be reused
+            bestWordCopy[ j] = ' ';
+            answerWord[ j] = ' ';
+        }
+    }
+
+    // Next blank out matching letters in different positions.
+    for( int j=0; j<wordLength; j++) {
+        // Compare the current (jth) bestWord letter to each answerWord (kth) letter.
+        for( int k=0; k<wordLength; k++) {
+            // If a match is found, blank out the answerWord letter so it will not contribute to scoring
+           if( bestWordCopy[ j] == answerWord[ k] ) {
+               answerWord[ k] = ' ';
+               break;   // Go on to next (jth) letter in the bestWordCopy
+           }
+        } //end for( int k...
+    } //end for( int j...
+} //end removeMatchingLettersOfLength(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Packed form of the answer words, stored position by position and letter by letter
+// (struct of arrays) so that a single guess can be compared against many answers at once.
+// Blanked-out letters from removeMatchingLetters(..) are stored as PACKED_NO_LETTER and are
+// not counted.  Arrays are padded to a multiple of PACKED_BLOCK_SIZE with answers that
+// can never score.
+typedef struct packedAnswers packedAnswersStruct;
+struct packedAnswers{
+    int count;              // How many answer words there are
+    int paddedCount;        // count rounded up to a multiple of PACKED_BLOCK_SIZE
+    uint8_t *letters;       // letters[ position * paddedCount + answer] is a letter 0..25
+    uint8_t *letterCounts;  // letterCounts[ letter * paddedCount + answer] is how often letter occurs
+    uint8_t *weights;       // How many identical answers each one stands for, or NULL for one each
+    int totalWeight;        // Sum of the weights, or count when weights is NULL
+};
+
+// Packed form of a guess word.  For each position we keep the letter and which occurrence
+// of that letter it is within the guess (1 for the first 'e', 2 for the second 'e', ...).
+// A guess letter scores its extra point against an answer when the answer has at least
+// that many copies of the letter, which adds up to the size of the letter multiset intersection.
+typedef struct packedGuess packedGuessStruct;
+struct packedGuess{
+    uint8_t letters[ MAX_WORD_LENGTH];
+    uint8_t occurrences[ MAX_WORD_LENGTH];
+    uint8_t sameLetters[ MAX_WORD_LENGTH];  // Bit k set when position k has the same letter
 };
 
 
-//-----------------------------------------------------------------------------------------
-// Count the number of words in an input file and return it.
-int countWordsInFile( char fileName[])
+//-----------------------------------------------------------------------------------------
+// Pack the answer words.  Returns 0 if some answer has a character that is not a lowercase
+// letter or blank, in which case the caller should use getScore(..) instead.
+int packAnswerWords(
+        wordCountStruct *answerWords,   // Array of the answer words
+        int *answerWeights,             // Weight of each answer, at most MAX_ANSWER_WEIGHT, or NULL
+        int answersWordCount,           // How many words there are in answerWords
+        packedAnswersStruct *packed)    // Packed answers to be allocated and filled in
+{
+    int paddedCount = (answersWordCount + PACKED_BLOCK_SIZE - 1) / PACKED_BLOCK_SIZE * PACKED_BLOCK_SIZE;
+    packed->count = answersWordCount;
+    packed->paddedCount = paddedCount;
+    packed->weights = NULL;
+    packed->totalWeight = answersWordCount;
+    if( answerWeights != NULL) {
+        // The padding gets weight 0
+        packed->weights = (uint8_t *) countedCalloc( paddedCount + 1, 1);
+        packed->totalWeight = 0;
+        for( int i=0; i<answersWordCount; i++) {
+            packed->weights[ i] = (uint8_t) answerWeights[ i];
+            packed->totalWeight += answerWeights[ i];
+        }
+    }
+    packed->letters = (uint8_t *) countedMalloc( (size_t) WordLength * paddedCount + 1);
+    packed->letterCounts = (uint8_t *) countedCalloc( (size_t) ALPHABET_SIZE * paddedCount + 1, 1);
+    memset( packed->letters, PACKED_NO_LETTER, (size_t) WordLength * paddedCount);
+
+    for( int i=0; i<answersWordCount; i++) {
+        for( int j=0; j<WordLength; j++) {
+            char c = answerWords[ i].word[ j];
+            if( c == ' ') {
+                continue;   // Blanked out, never matches
+            }
+            if( c < 'a' || c > 'z') {
+                return 0;
+            }
+            packed->letters[ j * paddedCount + i] = c - 'a';
+            packed->letterCounts[ (c - 'a') * paddedCount + i]++;
+        }
+    }
+    return 1;
+} //end packAnswerWords(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Release the arrays of a packed answer set.
+void freePackedAnswers( packedAnswersStruct *packed)
+{
+    free( packed->letters);
+    free( packed->letterCounts);
+    free( packed->weights);
+    packed->letters = NULL;
+    packed->letterCounts = NULL;
+    packed->weights = NULL;
+} //end freePackedAnswers(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Pack a guess word.  Returns 0 if the guess has a character that is not a lowercase letter.
+int packGuessWord( char theGuess[], packedGuessStruct *packed)
+{
+    for( int j=0; j<WordLength; j++) {
+        char c = theGuess[ j];
+        if( c < 'a' || c > 'z') {
+            return 0;
+        }
+        packed->letters[ j] = c - 'a';
+        packed->sameLetters[ j] = 1 << j;
+        for( int k=0; k<j; k++) {
+            if( theGuess[ k] == c) {
+                packed->sameLetters[ j] |= 1 << k;
+                packed->sameLetters[ k] |= 1 << j;
+            }
+        }
+    }
+    // The occurrence number is how many copies of the letter there are up to this position
+    for( int j=0; j<WordLength; j++) {
+        packed->occurrences[ j] = __builtin_popcount( packed->sameLetters[ j] & ((2 << j) - 1));
+    }
+    return 1;
+} //end packGuessWord(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Scalar version of the packed comparison.  Each answer gets 2 points per exact position
+// match plus 1 point per letter in common, which is the same as the 3-point / 1-point
+// scoring in getSingleWordComparisonScore(..).  If pairScores is not NULL the score against
+// each answer is also stored there, including zeros for the padding.  Weighted answers count
+// as many times as their weight in the total, but not in pairScores.
+ALWAYS_INLINE long getPackedScoreScalarOfLength( packedGuessStruct *guess, packedAnswersStruct *answers,
+                                                 uint8_t *pairScores, const int wordLength)
+{
+    int paddedCount = answers->paddedCount;
+    long score = 0;
+    for( int i=0; i<paddedCount; i++) {
+        int answerScore = 0;
+        for( int j=0; j<wordLength; j++) {
+            uint8_t letter = guess->letters[ j];
+            answerScore += 2 * (answers->letters[ j * paddedCount + i] == letter);
+            answerScore += answers->letterCounts[ letter * paddedCount + i] >= guess->occurrences[ j];
+        }
+        if( pairScores != NULL) {
+            pairScores[ i] = (uint8_t) answerScore;
+        }
+        score += answers->weights == NULL ? answerScore : answerScore * answers->weights[ i];
+    }
+    return score;
+} //end getPackedScoreScalarOfLength(..)
+
+
+#ifdef HAVE_X86_SIMD
+//-----------------------------------------------------------------------------------------
+// SSE2 version of the packed comparison, handling 16 answers per step.  Per-answer scores
+// are at most 3 * MAX_WORD_LENGTH so they fit in a byte, and are summed with _mm_sad_epu8.
+ALWAYS_INLINE long getPackedScoreSse2OfLength( packedGuessStruct *guess, packedAnswersStruct *answers,
+                                               uint8_t *pairScores, const int wordLength)
+{
+    int paddedCount = answers->paddedCount;
+    __m128i total = _mm_setzero_si128();
+    for( int i=0; i<paddedCount; i+=16) {
+        __m128i blockScore = _mm_setzero_si128();
+        for( int j=0; j<wordLength; j++) {
+            uint8_t letter = guess->letters[ j];
+            __m128i letters = _mm_loadu_si128( (__m128i *) &answers->letters[ j * paddedCount + i]);
+            __m128i counts = _mm_loadu_si128( (__m128i *) &answers->letterCounts[ letter * paddedCount + i]);
+            __m128i exact = _mm_cmpeq_epi8( letters, _mm_set1_epi8( (char) letter));
+            __m128i common = _mm_cmpgt_epi8( counts, _mm_set1_epi8( (char) (guess->occurrences[ j] - 1)));
+            // Comparison results are -1 where true, so subtracting adds the points
+            blockScore = _mm_sub_epi8( blockScore, _mm_add_epi8( exact, exact));
+            blockScore = _mm_sub_epi8( blockScore, common);
+        }
+        if( pairScores != NULL) {
+            _mm_storeu_si128( (__m128i *) &pairScores[ i], blockScore);
+        }
+        if( answers->weights == NULL) {
+            total = _mm_add_epi64( total, _mm_sad_epu8( blockScore, _mm_setzero_si128()));
+        }
+        else {
+            // Multiply by the weights in 16 bits and add pairs into 32 bits, then widen to 64
+            __m128i zero = _mm_setzero_si128();
+            __m128i weights = _mm_loadu_si128( (__m128i *) &answers->weights[ i]);
+            __m128i sum = _mm_add_epi32( _mm_madd_epi16( _mm_unpacklo_epi8( blockScore, zero), _mm_unpacklo_epi8( weights, zero)),
+                                         _mm_madd_epi16( _mm_unpackhi_epi8( blockScore, zero), _mm_unpackhi_epi8( weights, zero)));
+            total = _mm_add_epi64( total, _mm_add_epi64( _mm_unpacklo_epi32( sum, zero), _mm_unpackhi_epi32( sum, zero)));
+        }
+    }
+    return _mm_cvtsi128_si64( total) + _mm_cvtsi128_si64( _mm_unpackhi_epi64( total, total));
+} //end getPackedScoreSse2OfLength(..)
+
+
+//-----------------------------------------------------------------------------------------
+// AVX2 version of the packed comparison, handling 32 answers per step.
+__attribute__(( target( "avx2")))
+ALWAYS_INLINE long getPackedScoreAvx2OfLength( packedGuessStruct *guess, packedAnswersStruct *answers,
+                                               uint8_t *pairScores, const int wordLength)
+{
+    int paddedCount = answers->paddedCount;
+    __m256i total = _mm256_setzero_si256();
+    for( int i=0; i<paddedCount; i+=32) {
+        __m256i blockScore = _mm256_setzero_si256();
+        for( int j=0; j<wordLength; j++) {
+            uint8_t letter = guess->letters[ j];
+            __m256i letters = _mm256_loadu_si256( (__m256i *) &answers->letters[ j * paddedCount + i]);
+            __m256i counts = _mm256_loadu_si256( (__m256i *) &answers->letterCounts[ letter * paddedCount + i]);
+            __m256i exact = _mm256_cmpeq_epi8( letters, _mm256_set1_epi8( (char) letter));
+            __m256i common = _mm256_cmpgt_epi8( counts, _mm256_set1_epi8( (char) (guess->occurrences[ j] - 1)));
+            blockScore = _mm256_sub_epi8( blockScore, _mm256_add_epi8( exact, exact));
+            blockScore = _mm256_sub_epi8( blockScore, common);
+        }
+        if( pairScores != NULL) {
+            _mm256_storeu_si256( (__m256i *) &pairScores[ i], blockScore);
+        }
+        if( answers->weights == NULL) {
+            total = _mm256_add_epi64( total, _mm256_sad_epu8( blockScore, _mm256_setzero_si256()));
+        }
+        else {
+            __m256i zero = _mm256_setzero_si256();
+            __m256i weights = _mm256_loadu_si256( (__m256i *) &answers->weights[ i]);
+            __m256i sum = _mm256_add_epi32(
+                _mm256_madd_epi16( _mm256_cvtepu8_epi16( _mm256_castsi256_si128( blockScore)),
+                                   _mm256_cvtepu8_epi16( _mm256_castsi256_si128( weights))),
+                _mm256_madd_epi16( _mm256_cvtepu8_epi16( _mm256_extracti128_si256( blockScore, 1)),
+                                   _mm256_cvtepu8_epi16( _mm256_extracti128_si256( weights, 1))));
+            total = _mm256_add_epi64( total, _mm256_add_epi64( _mm256_unpacklo_epi32( sum, zero), _mm256_unpackhi_epi32( sum, zero)));
+        }
+    }
+    __m128i half = _mm_add_epi64( _mm256_castsi256_si128( total), _mm256_extracti128_si256( total, 1));
+    return _mm_cvtsi128_si64( half) + _mm_cvtsi128_si64( _mm_unpackhi_epi64( half, half));
+} //end getPackedScoreAvx2OfLength(..)
+#endif
+
+
+//-----------------------------------------------------------------------------------------
+// Compute the feedback pattern of a guess against the packed answers start..start+count-1.
+// Each letter gets a color digit, 2 for green (right letter, right position), 1 for yellow
+// (letter elsewhere in the answer) and 0 for grey, and the pattern code is the number these
+// digits make in base 3 with the first letter as the lowest digit.  Like in Wordle, a repeated
+// guess letter is only yellow while the answer still has copies not used by greens or by
+// earlier yellows.  Codes go up to 3 to the power MAX_WORD_LENGTH, so they take 16 bits.
+ALWAYS_INLINE void getPatternCodesScalarOfLength( packedGuessStruct *guess, packedAnswersStruct *answers,
+                                                  int start, int count, uint16_t *codes, const int wordLength)
+{
+    int paddedCount = answers->paddedCount;
+    for( int i=start; i<start + count; i++) {
+        int greens = 0;
+        for( int j=0; j<wordLength; j++) {
+            greens |= (answers->letters[ j * paddedCount + i] == guess->letters[ j]) << j;
+        }
+        int code = 0;
+        int power = 1;
+        for( int j=0; j<wordLength; j++) {
+            int color = 0;
+            if( greens >> j & 1) {
+                color = 2;
+            }
+            else {
+                // Copies of this letter needed: greens anywhere plus non-greens up to here
+                int sameLetters = guess->sameLetters[ j];
+                int needed = __builtin_popcount( sameLetters & greens)
+                             + __builtin_popcount( sameLetters & ~greens & ((2 << j) - 1));
+                color = answers->letterCounts[ guess->letters[ j] * paddedCount + i] >= needed;
+            }
+            code += color * power;
+            power *= 3;
+        }
+        codes[ i - start] = (uint16_t) code;
+    }
+} //end getPatternCodesScalarOfLength(..)
+
+
+#ifdef HAVE_X86_SIMD
+//-----------------------------------------------------------------------------------------
+// AVX2 version of getPatternCodesScalarOfLength(..), computing the patterns of 32 answers per
+// step.  count must be a multiple of 32.  The first 5 digits are added up in bytes, since
+// 3 to the power 5 still fits, and the rest after widening to 16 bits.
+#define PATTERN_BYTE_DIGITS 5
+__attribute__(( target( "avx2")))
+ALWAYS_INLINE void getPatternCodesAvx2OfLength( packedGuessStruct *guess, packedAnswersStruct *answers,
+                                                int start, int count, uint16_t *codes, const int wordLength)
+{
+    int paddedCount = answers->paddedCount;
+    for( int i=start; i<start + count; i+=32) {
+        // greens[ j] is -1 for answers where letter j is green, 0 otherwise
+        __m256i greens[ MAX_WORD_LENGTH];
+        for( int j=0; j<wordLength; j++) {
+            __m256i letters = _mm256_loadu_si256( (__m256i *) &answers->letters[ j * paddedCount + i]);
+            greens[ j] = _mm256_cmpeq_epi8( letters, _mm256_set1_epi8( (char) guess->letters[ j]));
+        }
+
+        __m256i code = _mm256_setzero_si256();
+        __m256i lowCodes = _mm256_setzero_si256();     // 16-bit codes of the first 16 answers
+        __m256i highCodes = _mm256_setzero_si256();    // and of the last 16
+        int power = 1;
+        for( int j=0; j<wordLength; j++) {
+            // Subtracting the -1 masks counts the copies of this letter that are needed
+            __m256i needed = _mm256_setzero_si256();
+            for( int k=0; k<wordLength; k++) {
+                if( guess->sameLetters[ j] >> k & 1) {
+                    needed = _mm256_sub_epi8( needed, greens[ k]);
+                    if( k <= j) {
+                        needed = _mm256_sub_epi8( needed, _mm256_andnot_si256( greens[ k], _mm256_set1_epi8( -1)));
+                    }
+                }
+            }
+            __m256i counts = _mm256_loadu_si256( (__m256i *) &answers->letterCounts[ guess->letters[ j] * paddedCount + i]);
+            __m256i yellow = _mm256_andnot_si256( greens[ j],
+                                 _mm256_cmpgt_epi8( counts, _mm256_sub_epi8( needed, _mm256_set1_epi8( 1))));
+            if( j < PATTERN_BYTE_DIGITS) {
+                code = _mm256_add_epi8( code, _mm256_and_si256( greens[ j], _mm256_set1_epi8( (char) (2 * power))));
+                code = _mm256_add_epi8( code, _mm256_and_si256( yellow, _mm256_set1_epi8( (char) power)));
+            }
+            else {
+                __m256i color = _mm256_sub_epi8( _mm256_setzero_si256(), _mm256_add_epi8( _mm256_add_epi8( greens[ j], greens[ j]), yellow));
+                __m256i powers = _mm256_set1_epi16( (short) power);
+                lowCodes = _mm256_add_epi16( lowCodes, _mm256_mullo_epi16( _mm256_cvtepu8_epi16( _mm256_castsi256_si128( color)), powers));
+                highCodes = _mm256_add_epi16( highCodes, _mm256_mullo_epi16( _mm256_cvtepu8_epi16( _mm256_extracti128_si256( color, 1)), powers));
+            }
+            power *= 3;
+        }
+        lowCodes = _mm256_add_epi16( lowCodes, _mm256_cvtepu8_epi16( _mm256_castsi256_si128( code)));
+        highCodes = _mm256_add_epi16( highCodes, _mm256_cvtepu8_epi16( _mm256_extracti128_si256( code, 1)));
+        _mm256_storeu_si256( (__m256i *) &codes[ i - start], lowCodes);
+        _mm256_storeu_si256( (__m256i *) &codes[ i - start + 16], highCodes);
+    }
+} //end getPatternCodesAvx2OfLength(..)
+#endif
+
+
+//-----------------------------------------------------------------------------------------
+// Letter statistics of a set of answer words.  The score of a guess against one answer is
+// 2 points per exact position match plus the number of letters the two words share, so the
+// total over all answers only depends on how many answers have each letter in each position
+// and how many answers have at least k copies of each letter.
+typedef struct answerStatistics answerStatisticsStruct;
+struct answerStatistics{
+    int positionCounts[ MAX_WORD_LENGTH][ ALPHABET_SIZE];     // Answers with the letter in that position
+    int atLeastCounts[ ALPHABET_SIZE][ MAX_WORD_LENGTH + 1];  // [letter][k] = answers with at least k copies
+};
+
+
+//-----------------------------------------------------------------------------------------
+// Build the letter statistics for the answer words.  Blanked-out letters are ignored, both
+// those stored as blanks and those marked in blankedMasks (bit j set means letter j is
+// blanked out), which may be NULL.  Each answer counts as many times as its weight.
+// Returns 0 if some answer has a character that is not a lowercase letter or blank.
+int buildAnswerStatistics(
+        wordCountStruct *answerWords,       // Array of the answer words
+        uint8_t *blankedMasks,              // Blanked letters of each answer, or NULL
+        int *answerWeights,                 // Weight of each answer, or NULL for one each
+        int answersWordCount,               // How many words there are in answerWords
+        answerStatisticsStruct *statistics) // Statistics to be filled in
+{
+    memset( statistics, 0, sizeof( answerStatisticsStruct));
+    for( int i=0; i<answersWordCount; i++) {
+        int letterCounts[ ALPHABET_SIZE] = { 0};
+        int weight = answerWeights == NULL ? 1 : answerWeights[ i];
+        for( int j=0; j<WordLength; j++) {
+            char c = answerWords[ i].word[ j];
+            if( c == ' ' || (blankedMasks != NULL && (blankedMasks[ i] >> j & 1))) {
+                continue;   // Blanked out, never matches
+            }
+            if( c < 'a' || c > 'z') {
+                return 0;
+            }
+            statistics->positionCounts[ j][ c - 'a'] += weight;
+            // This is copy number letterCounts[..] of the letter in this answer
+            statistics->atLeastCounts[ c - 'a'][ ++letterCounts[ c - 'a']] += weight;
+        }
+    }
+    return 1;
+} //end buildAnswerStatistics(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Score a packed guess against all answers in constant time using their letter statistics.
+ALWAYS_INLINE int getAggregateScoreOfLength( packedGuessStruct *guess, answerStatisticsStruct *statistics,
+                                             const int wordLength)
+{
+    int score = 0;
+    for( int j=0; j<wordLength; j++) {
+        score += 2 * statistics->positionCounts[ j][ guess->letters[ j]];
+        score += statistics->atLeastCounts[ guess->letters[ j]][ guess->occurrences[ j]];
+    }
+    return score;
+} //end getAggregateScoreOfLength(..)
+
+
+//-----------------------------------------------------------------------------------------
+// The kernels for one word length, see selectWordLengthKernels(..).
+typedef long (*packedScoreFunction)( packedGuessStruct *, packedAnswersStruct *, uint8_t *);
+typedef void (*patternCodeFunction)( packedGuessStruct *, packedAnswersStruct *, int, int, uint16_t *);
+typedef struct wordLengthKernels wordLengthKernelsStruct;
+struct wordLengthKernels{
+    int wordLength;                 // Letters per word
+    int patternCount;               // Feedback patterns: 3 to the power wordLength
+    int (*compareWords)( char [], char []);
+    void (*removeMatchingLetters)( char [], char []);
+    int (*getAggregateScore)( packedGuessStruct *, answerStatisticsStruct *);
+    packedScoreFunction packedScoreScalar;
+    packedScoreFunction packedScoreSse2;     // NULL when not built for x86
+    packedScoreFunction packedScoreAvx2;     // NULL when not built for x86
+    patternCodeFunction patternCodesScalar;
+    patternCodeFunction patternCodesAvx2;    // NULL when not built for x86
+};
+
+// Define the kernel instances for words of length L
+#define DEFINE_WORD_LENGTH_KERNELS( L) \
+    int compareWords##L( char originalWord[], char comparisonWord[]) { \
+        return compareWordsOfLength( originalWord, comparisonWord, L); } \
+    void removeMatchingLetters##L( char answerWord[], char bestWord[]) { \
+        removeMatchingLettersOfLength( answerWord, bestWord, L); } \
+    int getAggregateScore##L( packedGuessStruct *guess, answerStatisticsStruct *statistics) { \
+        return getAggregateScoreOfLength( guess, statistics, L); } \
+    long getPackedScoreScalar##L( packedGuessStruct *guess, packedAnswersStruct *answers, uint8_t *pairScores) { \
+        return getPackedScoreScalarOfLength( guess, answers, pairScores, L); } \
+    void getPatternCodesScalar##L( packedGuessStruct *guess, packedAnswersStruct *answers, int start, int count, uint16_t *codes) { \
+        getPatternCodesScalarOfLength( guess, answers, start, count, codes, L); }
+
+#ifdef HAVE_X86_SIMD
+#define DEFINE_WORD_LENGTH_SIMD_KERNELS( L) \
+    long getPackedScoreSse2##L( packedGuessStruct *guess, packedAnswersStruct *answers, uint8_t *pairScores) { \
+        return getPackedScoreSse2OfLength( guess, answers, pairScores, L); } \
+    __attribute__(( target( "avx2"))) \
+    long getPackedScoreAvx2##L( packedGuessStruct *guess, packedAnswersStruct *answers, uint8_t *pairScores) { \
+        return getPackedScoreAvx2OfLength( guess, answers, pairScores, L); } \
+    __attribute__(( target( "avx2"))) \
+    void getPatternCodesAvx2##L( packedGuessStruct *guess, packedAnswersStruct *answers, int start, int count, uint16_t *codes) { \
+        getPatternCodesAvx2OfLength( guess, answers, start, count, codes, L); }
+#define WORD_LENGTH_SIMD_KERNELS( L) getPackedScoreSse2##L, getPackedScoreAvx2##L, getPatternCodesScalar##L, getPatternCodesAvx2##L
+#else
+#define DEFINE_WORD_LENGTH_SIMD_KERNELS( L)
+#define WORD_LENGTH_SIMD_KERNELS( L) NULL, NULL, getPatternCodesScalar##L, NULL
+#endif
+
+#define WORD_LENGTH_KERNELS( L, PATTERNS) { L, PATTERNS, compareWords##L, removeMatchingLetters##L, \
+    getAggregateScore##L, getPackedScoreScalar##L, WORD_LENGTH_SIMD_KERNELS( L)}
+
+DEFINE_WORD_LENGTH_KERNELS( 4)
+DEFINE_WORD_LENGTH_KERNELS( 5)
+DEFINE_WORD_LENGTH_KERNELS( 6)
+DEFINE_WORD_LENGTH_KERNELS( 7)
+DEFINE_WORD_LENGTH_KERNELS( 8)
+DEFINE_WORD_LENGTH_SIMD_KERNELS( 4)
+DEFINE_WORD_LENGTH_SIMD_KERNELS( 5)
+DEFINE_WORD_LENGTH_SIMD_KERNELS( 6)
+DEFINE_WORD_LENGTH_SIMD_KERNELS( 7)
+DEFINE_WORD_LENGTH_SIMD_KERNELS( 8)
+
+// Indexed by word length - MIN_WORD_LENGTH
+wordLengthKernelsStruct WordLengthKernels[ MAX_WORD_LENGTH - MIN_WORD_LENGTH + 1] = {
+    WORD_LENGTH_KERNELS( 4, 81),
+    WORD_LENGTH_KERNELS( 5, 243),
+    WORD_LENGTH_KERNELS( 6, 729),
+    WORD_LENGTH_KERNELS( 7, 2187),
+    WORD_LENGTH_KERNELS( 8, 6561)
+};
+wordLengthKernelsStruct *Kernels = &WordLengthKernels[ 5 - MIN_WORD_LENGTH];   // Chosen when words are loaded
+
+
+//-----------------------------------------------------------------------------------------
+// Use the kernels for words of the given length from now on.
+void selectWordLengthKernels( int wordLength)
+{
+    Kernels = &WordLengthKernels[ wordLength - MIN_WORD_LENGTH];
+} //end selectWordLengthKernels(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Choose the fastest packed comparison kernel the processor supports.
+packedScoreFunction selectPackedScoreFunction()
+{
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports( "avx2")) {
+        return Kernels->packedScoreAvx2;
+    }
+#if defined( __x86_64__)
+    return Kernels->packedScoreSse2;   // SSE2 is always present on x86-64
+#else
+    if( __builtin_cpu_supports( "sse2")) {
+        return Kernels->packedScoreSse2;
+    }
+#endif
+#endif
+    return Kernels->packedScoreScalar;
+} //end selectPackedScoreFunction()
+
+
+//-----------------------------------------------------------------------------------------
+// Choose the fastest feedback pattern kernel the processor supports.
+patternCodeFunction selectPatternCodeFunction()
+{
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports( "avx2")) {
+        return Kernels->patternCodesAvx2;
+    }
+#endif
+    return Kernels->patternCodesScalar;
+} //end selectPatternCodeFunction()
+
+
+//-----------------------------------------------------------------------------------------
+// Score a guess from the histogram of the feedback patterns it gets against answersWordCount
+// answers, for the ENGINE_ENTROPY or ENGINE_ELIMINATED engine.
+int getPatternHistogramScore( uint32_t *histogram, int answersWordCount, int engine)
+{
+    double information = 0.0;       // Expected information, in bits
+    double sumOfSquares = 0.0;      // Sum over patterns of answers-with-that-pattern squared
+    for( int code=0; code<Kernels->patternCount; code++) {
+        if( histogram[ code] > 0) {
+            double probability = (double) histogram[ code] / answersWordCount;
+            information -= probability * log2( probability);
+            sumOfSquares += (double) histogram[ code] * histogram[ code];
+        }
+    }
+    if( engine == ENGINE_ENTROPY) {
+        return (int) lround( 1000.0 * information);
+    }
+    // The answers left after the feedback are the ones sharing its pattern, so on average
+    // sumOfSquares / answersWordCount remain.
+    return (int) lround( 1000.0 * (answersWordCount - sumOfSquares / answersWordCount));
+} //end getPatternHistogramScore(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Calculate the word comparison score, where it gets:
+//   - One point for each correct letter in an incorrect position
+//   - Three points for each correct letter in the correct position
+int getSingleWordComparisonScore( char originalWordParameter[], char comparisonWordParameter[])
+{
+    return Kernels->compareWords( originalWordParameter, comparisonWordParameter);
+} //end getSingleWordComparisonScore(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Score a packed guess against all answers in constant time using their letter statistics.
+int getAggregateScore( packedGuessStruct *guess, answerStatisticsStruct *statistics)
+{
+    return Kernels->getAggregateScore( guess, statistics);
+} //end getAggregateScore(..)
+
+
+//-----------------------------------------------------------------------------------------
+// For the given word, calculate its score by comparing how well it matches each answer word.
+int getScore( char theGuess[],              // Word being evaluated as a guess
+              wordCountStruct *answerWords, // All the answer words, which theGuess is compared against
+              int answersWordCount)         // Number of words in answers file
+{
+    int score = 0;
+    for( int i=0; i<answersWordCount; i++) {
+        score += getSingleWordComparisonScore( theGuess, answerWords[ i].word);
+    }
+    return score;
+}
+
+
+//-----------------------------------------------------------------------------------------
+// Same as getScore(..), with each answer counted as many times as its weight.
+int getWeightedScore( char theGuess[],              // Word being evaluated as a guess
+                      wordCountStruct *answerWords, // The answer words
+                      int *answerWeights,           // Weight of each answer
+                      int answersWordCount)         // Number of answer words
+{
+    int score = 0;
+    for( int i=0; i<answersWordCount; i++) {
+        score += answerWeights[ i] * getSingleWordComparisonScore( theGuess, answerWords[ i].word);
+    }
+    return score;
+} //end getWeightedScore(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Comparator for use in built-in qsort(..) function.  Parameters are declared to be a
+// generic type, so they will match with anything.
+// This is a two-part comparison.  First the scores are compared.  If they are the same,
+// then the words themselves are also compared, so that the results are in descending
+// order by score, and within score they are in alphabetic order.
+int compareFunction( const void * a, const void * b) {
+    // Before using parameters we have cast them into the actual type they are in our program
+    // and then extract the numerical value used in comparison
+    int firstScore = ((wordCountStruct *) a)->score;
+    int secondScore = ((wordCountStruct *) b)->score;
+
+    // If scores are different, then that's all we need for our comparison.
+    if (firstScore != secondScore) {
+        // We reverse the values, so the result is in descending vs. the otherwise ascending order
+        // return firstScore - secondScore;   // ascending order
+        return secondScore - firstScore;      // descending order
+    }
+    else {
+        // Scores are equal, so check words themselves, to put them in alphabetical order
+        return strcmp( ((wordCountStruct *)a)->word,  ((wordCountStruct *)b)->word );
+    }
+} //end compareFunction(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Work shared between the threads of runInParallel(..).  Threads repeatedly claim the next
+// chunk of items by atomically advancing nextIndex, so faster threads simply take more chunks.
+typedef void (*parallelWorkFunction)( void *context, int start, int end);
+typedef struct parallelLoop parallelLoopStruct;
+struct parallelLoop{
+    parallelWorkFunction work;      // Called for each claimed range of items [start, end)
+    void *context;                  // Passed through to work
+    int itemCount;                  // How many items there are in total
+    int chunkSize;                  // How many items a thread claims at a time
+    int nextIndex;                  // Next item not yet claimed by any thread
+};
+
+
+//-----------------------------------------------------------------------------------------
+// Return how many threads should be used for scoring, based on NumberOfThreads, or the
+// threads left for each task when called from inside a task.
+int getScoringThreadCount()
+{
+    if( TaskThreadCount > 0) {
+        return TaskThreadCount;
+    }
+    if( NumberOfThreads > 0) {
+        return NumberOfThreads;
+    }
+    long coreCount = sysconf( _SC_NPROCESSORS_ONLN);
+    return coreCount > 0 ? (int) coreCount : 1;
+} //end getScoringThreadCount()
+
+
+//-----------------------------------------------------------------------------------------
+// Thread body: claim chunks of items until none are left, calling work on each chunk.
+void *parallelLoopWorker( void *loopParameter)
+{
+    parallelLoopStruct *loop = (parallelLoopStruct *) loopParameter;
+    while( 1) {
+        int start = __atomic_fetch_add( &loop->nextIndex, loop->chunkSize, __ATOMIC_RELAXED);
+        if( start >= loop->itemCount) {
+            break;
+        }
+        int end = start + loop->chunkSize;
+        if( end > loop->itemCount) {
+            end = loop->itemCount;
+        }
+        loop->work( loop->context, start, end);
+    }
+    return NULL;
+} //end parallelLoopWorker(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Call work on chunks of the items 0..itemCount-1, spreading the chunks across
+// getScoringThreadCount() threads.  The calling thread also takes part in the work.
+void runInParallel(
+        int itemCount,              // How many items there are
+        int chunkSize,              // How many items a thread claims at a time
+        parallelWorkFunction work,  // Called for each claimed range of items
+        void *context)              // Passed through to work
+{
+    parallelLoopStruct loop = { work, context, itemCount, chunkSize, 0};
+
+    // No point starting more threads than there are chunks of work
+    int threadCount = getScoringThreadCount();
+    int chunkCount = (itemCount + chunkSize - 1) / chunkSize;
+    if( threadCount > chunkCount) {
+        threadCount = chunkCount;
+    }
+
+    // Start the helper threads.  If a thread cannot be created the remaining work is
+    // simply picked up by the threads that did start.
+    pthread_t *threads = (pthread_t *) countedMalloc( sizeof( pthread_t) * (threadCount > 1 ? threadCount : 1));
+    int startedCount = 0;
+    for( int i=1; i<threadCount; i++) {
+        if( pthread_create( &threads[ startedCount], NULL, parallelLoopWorker, &loop) == 0) {
+            startedCount++;
+        }
+    }
+
+    parallelLoopWorker( &loop);
+    for( int i=0; i<startedCount; i++) {
+        pthread_join( threads[ i], NULL);
+    }
+    free( threads);
+} //end runInParallel(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Guess-by-answer score matrix, one byte per pair.  Row r holds the scores of the word read
+// into position r of allWords against every answer, padded to rowStride bytes with zeros.
+typedef struct scoreMatrix scoreMatrixStruct;
+struct scoreMatrix{
+    wordCountStruct *answerWords;   // Answer words the matrix was built for
+    int answersWordCount;           // Number of columns actually used
+    int totalWordCount;             // Number of rows
+    int rowStride;                  // Bytes per row, a multiple of PACKED_BLOCK_SIZE
+    uint8_t *rows;                  // First row, inside the mapped or allocated region
+};
+scoreMatrixStruct ScoreMatrix = { NULL, 0, 0, 0, NULL};   // Loaded with --cache FILE
+
+// Header at the start of a score matrix file.  The rows follow immediately after.
+typedef struct scoreMatrixHeader scoreMatrixHeaderStruct;
+struct scoreMatrixHeader{
+    char magic[ 8];                 // SCORE_MATRIX_MAGIC, not NULL terminated
+    uint32_t version;               // SCORE_MATRIX_VERSION
+    uint32_t wordLength;            // WordLength the file was built with
+    uint64_t contentHash;           // Hash of the answers and guesses file contents
+    uint32_t answersWordCount;      // Columns
+    uint32_t totalWordCount;        // Rows
+    uint32_t rowStride;             // Bytes per row
+    uint32_t reserved;              // Keeps the rows 8-byte aligned
+};
+
+
+//-----------------------------------------------------------------------------------------
+// Add up a row of per-answer scores.  Rows are padded to a multiple of PACKED_BLOCK_SIZE.
+int sumScoreMatrixRow( uint8_t *row, int rowStride)
+{
+#ifdef HAVE_X86_SIMD
+    __m128i total = _mm_setzero_si128();
+    for( int i=0; i<rowStride; i+=16) {
+        total = _mm_add_epi64( total, _mm_sad_epu8( _mm_loadu_si128( (__m128i *) &row[ i]), _mm_setzero_si128()));
+    }
+    return (int) (_mm_cvtsi128_si64( total) + _mm_cvtsi128_si64( _mm_unpackhi_epi64( total, total)));
+#else
+    int score = 0;
+    for( int i=0; i<rowStride; i++) {
+        score += row[ i];
+    }
+    return score;
+#endif
+} //end sumScoreMatrixRow(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Raise the top score shared by the scoring threads to rangeTopScore, if that is higher.
+void foldTopScore( int *topScore, int rangeTopScore)
+{
+    int seenTopScore = __atomic_load_n( topScore, __ATOMIC_RELAXED);
+    while( rangeTopScore > seenTopScore
+           && ! __atomic_compare_exchange_n( topScore, &seenTopScore, rangeTopScore, 0,
+                                             __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        // seenTopScore was reloaded by the failed exchange, so just try again
+    }
+} //end foldTopScore(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Everything the scoring threads need to know to score a range of allWords.
+typedef struct scoringJob scoringJobStruct;
+struct scoringJob{
+    wordCountStruct *answerWords;   // Array of the answer words
+    int *answerWeights;             // Weight of each answer, or NULL for one each
+    int answersWordCount;           // How many words there are in answerWords
+    wordCountStruct *allWords;      // Array of all the words, whose scores are filled in
+    int *firstCopies;               // Index of the first copy of each word, or NULL, see getFirstCopies(..)
+    packedAnswersStruct *packed;    // Packed answers, or NULL if not used
+    packedScoreFunction packedScore; // Kernel used to compare a guess against packed answers
+    answerStatisticsStruct *statistics; // Answer letter statistics, or NULL if not used
+    scoreMatrixStruct *matrix;      // Precomputed scores for these answers, or NULL if not used
+    int topScore;                   // Highest score seen so far by any thread
+};
+
+
+//-----------------------------------------------------------------------------------------
+// Score the words allWords[ start..end-1].  Each word's score depends only on that word,
+// so the result is the same however the words are split between threads.
+void scoreWordRange( void *jobParameter, int start, int end)
+{
+    scoringJobStruct *job = (scoringJobStruct *) jobParameter;
+    int rangeTopScore = INT_MIN;
+    for( int i=start; i<end; i++) {
+        packedGuessStruct guess;
+        if( job->firstCopies != NULL && job->firstCopies[ i] != i) {
+            continue;   // Scored with its first copy
+        }
+        if( job->matrix != NULL) {
+            scoreMatrixStruct *matrix = job->matrix;
+            uint8_t *row = matrix->rows + (size_t) job->allWords[ i].wordIndex * matrix->rowStride;
+            job->allWords[ i].score = sumScoreMatrixRow( row, matrix->rowStride);
+        }
+        else if( (job->packed == NULL && job->statistics == NULL) || ! packGuessWord( job->allWords[ i].word, &guess)) {
+            job->allWords[ i].score = job->answerWeights == NULL
+                ? getScore( job->allWords[ i].word, job->answerWords, job->answersWordCount)
+                : getWeightedScore( job->allWords[ i].word, job->answerWords, job->answerWeights, job->answersWordCount);
+        }
+        else if( job->statistics != NULL) {
+            job->allWords[ i].score = getAggregateScore( &guess, job->statistics);
+        }
+        else {
+            job->allWords[ i].score = (int) job->packedScore( &guess, job->packed, NULL);
+        }
+        if( job->allWords[ i].score > rangeTopScore) {
+            rangeTopScore = job->allWords[ i].score;
+        }
+    }
+
+    foldTopScore( &job->topScore, rangeTopScore);
+} //end scoreWordRange(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Everything the threads need to score a range of allWords by feedback patterns.
+typedef struct patternJob patternJobStruct;
+struct patternJob{
+    wordCountStruct *allWords;      // Array of all the words, whose scores are filled in
+    int *firstCopies;               // Index of the first copy of each word, or NULL
+    int totalWordCount;             // How many words there are in allWords
+    packedAnswersStruct *packed;    // Packed answers
+    patternCodeFunction patternCodes; // Kernel computing the patterns of a guess
+    int engine;                     // ENGINE_ENTROPY or ENGINE_ELIMINATED
+    int topScore;                   // Highest score seen so far by any thread
+};
+
+
+//-----------------------------------------------------------------------------------------
+// Score the tiles of PATTERN_GUESS_TILE words start..end-1 by the histogram of their feedback
+// patterns.  Each tile of answers is compared against every guess in the guess tile while it
+// is still in cache, before moving on to the next tile of answers.
+void scorePatternTiles( void *jobParameter, int start, int end)
+{
+    patternJobStruct *job = (patternJobStruct *) jobParameter;
+    packedAnswersStruct *packed = job->packed;
+    int patternCount = Kernels->patternCount;
+    uint32_t *histograms = (uint32_t *) countedMalloc( sizeof( uint32_t) * PATTERN_GUESS_TILE * patternCount);
+    uint16_t *codes = (uint16_t *) countedMalloc( sizeof( uint16_t) * PATTERN_ANSWER_TILE);
+    packedGuessStruct guesses[ PATTERN_GUESS_TILE];
+    int rangeTopScore = INT_MIN;
+
+    for( int tile=start; tile<end; tile++) {
+        int firstGuess = tile * PATTERN_GUESS_TILE;
+        int guessCount = job->totalWordCount - firstGuess;
+        if( guessCount > PATTERN_GUESS_TILE) {
+            guessCount = PATTERN_GUESS_TILE;
+        }
+        memset( histograms, 0, sizeof( uint32_t) * PATTERN_GUESS_TILE * patternCount);
+        for( int g=0; g<guessCount; g++) {
+            packGuessWord( job->allWords[ firstGuess + g].word, &guesses[ g]);
+        }
+
+        for( int answerStart=0; answerStart<packed->paddedCount; answerStart+=PATTERN_ANSWER_TILE) {
+            int answerCount = packed->paddedCount - answerStart;
+            if( answerCount > PATTERN_ANSWER_TILE) {
+                answerCount = PATTERN_ANSWER_TILE;
+            }
+            // Only real answers count, not the padding at the end
+            int realCount = packed->count - answerStart < answerCount ? packed->count - answerStart : answerCount;
+            for( int g=0; g<guessCount; g++) {
+                if( job->firstCopies != NULL && job->firstCopies[ firstGuess + g] != firstGuess + g) {
+                    continue;   // Scored with its first copy
+                }
+                job->patternCodes( &guesses[ g], packed, answerStart, answerCount, codes);
+                uint32_t *histogram = &histograms[ g * patternCount];
+                if( packed->weights == NULL) {
+                    for( int i=0; i<realCount; i++) {
+                        histogram[ codes[ i]]++;
+                    }
+                }
+                else {
+                    for( int i=0; i<realCount; i++) {
+                        histogram[ codes[ i]] += packed->weights[ answerStart + i];
+                    }
+                }
+            }
+        }
+
+        for( int g=0; g<guessCount; g++) {
+            if( job->firstCopies != NULL && job->firstCopies[ firstGuess + g] != firstGuess + g) {
+                continue;
+            }
+            int score = getPatternHistogramScore( &histograms[ g * patternCount], packed->totalWeight, job->engine);
+            job->allWords[ firstGuess + g].score = score;
+            if( score > rangeTopScore) {
+                rangeTopScore = score;
+            }
+        }
+    }
+
+    foldTopScore( &job->topScore, rangeTopScore);
+    free( histograms);
+    free( codes);
+} //end scorePatternTiles(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Hash table from words, which may have blanked-out letters, to an index.  Used to find
+// identical words.  Open addressing, with room for at least twice as many words as are added.
+typedef struct wordTable wordTableStruct;
+struct wordTable{
+    uint64_t *keys;         // Letters of each word packed into 64 bits, 0 for an empty slot
+    int *indexes;           // Index stored for each word
+    int mask;               // Number of slots - 1, a power of 2 - 1
+};
+
+
+//-----------------------------------------------------------------------------------------
+// Allocate an empty table with room for wordCount words.
+void createWordTable( wordTableStruct *table, int wordCount)
+{
+    int slotCount = 16;
+    while( slotCount < 2 * wordCount) {
+        slotCount *= 2;
+    }
+    table->keys = (uint64_t *) countedCalloc( slotCount, sizeof( uint64_t));
+    table->indexes = (int *) countedMalloc( sizeof( int) * slotCount);
+    table->mask = slotCount - 1;
+} //end createWordTable(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Release the arrays of a word table.
+void freeWordTable( wordTableStruct *table)
+{
+    free( table->keys);
+    free( table->indexes);
+} //end freeWordTable(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Return where the index for the given word is stored, adding the word with index -1 if it
+// is not in the table yet.
+int *findWordInTable( wordTableStruct *table, char word[])
+{
+    uint64_t key = 0;
+    memcpy( &key, word, WordLength);    // Never 0, since letters and blanks are not 0
+    int slot = (int) ((key * 0x9E3779B97F4A7C15ULL) >> 32) & table->mask;
+    while( table->keys[ slot] != 0 && table->keys[ slot] != key) {
+        slot = (slot + 1) & table->mask;
+    }
+    if( table->keys[ slot] == 0) {
+        table->keys[ slot] = key;
+        table->indexes[ slot] = -1;
+    }
+    return &table->indexes[ slot];
+} //end findWordInTable(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Where each word in allWords first appears in it, so that repeated words (like the answers,
+// which are usually in the guesses file too) are only scored once.  Kept from one call to
+// the next while allWords, or a copy of it, has its repeats in the same places.
+typedef struct firstCopies firstCopiesStruct;
+struct firstCopies{
+    int totalWordCount;             // How many words the indexes are for
+    int *indexes;                   // indexes[ i] is the first i' with the same word as i
+    int repeatCount;                // How many words are repeats of an earlier word
+};
+firstCopiesStruct FirstCopies = { 0, NULL, 0};
+
+
+//-----------------------------------------------------------------------------------------
+// Return for each word of allWords the index of its first copy, or NULL if no word is repeated
+// or there are too few words to bother.  Inside tasks the kept indexes are only read, so a
+// task scoring an array that does not match them scores every word.
+int *getFirstCopies( wordCountStruct *allWords, int totalWordCount)
+{
+    if( totalWordCount < SCORING_CHUNK_SIZE) {
+        return NULL;    // Not worth it, and would replace the kept indexes for allWords
+    }
+    // Any array with the same words in the places of the known repeats can use the indexes,
+    // like the copies of allWords scored by the tasks of findAndDisplayAllBestSecondWords(..).
+    // Without known repeats there is nothing to check the words against, and the same array
+    // may since have been refilled, like the tiles of a word stream, so look again.
+    int isCurrent = FirstCopies.totalWordCount == totalWordCount && FirstCopies.repeatCount > 0;
+    for( int i=0; isCurrent && i<totalWordCount; i++) {
+        int first = FirstCopies.indexes[ i];
+        isCurrent = first == i || strcmp( allWords[ i].word, allWords[ first].word) == 0;
+    }
+    if( ! isCurrent && TaskThreadCount > 0) {
+        return NULL;
+    }
+    if( ! isCurrent) {
+        free( FirstCopies.indexes);
+        FirstCopies.totalWordCount = totalWordCount;
+        FirstCopies.indexes = (int *) countedMalloc( sizeof( int) * (totalWordCount + 1));
+        FirstCopies.repeatCount = 0;
+        wordTableStruct table;
+        createWordTable( &table, totalWordCount);
+        for( int i=0; i<totalWordCount; i++) {
+            int *first = findWordInTable( &table, allWords[ i].word);
+            if( *first < 0) {
+                *first = i;
+            }
+            FirstCopies.indexes[ i] = *first;
+            FirstCopies.repeatCount += *first != i;
+        }
+        freeWordTable( &table);
+    }
+    return FirstCopies.repeatCount > 0 ? FirstCopies.indexes : NULL;
+} //end getFirstCopies(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Answers made ready once for the chosen engine, so that any number of arrays of words can
+// be scored against them with scoreWordsAgainstAnswers(..).
+typedef struct preparedAnswers preparedAnswersStruct;
+struct preparedAnswers{
+    wordCountStruct *answerWords;   // Array of the answer words
+    int *answerWeights;             // Weight of each answer, or NULL for one each
+    int answersWordCount;           // How many words there are in answerWords
+    int useMatrix;                  // Set when the score matrix rows are added up instead
+    int isPacked;                   // Set when packed holds the answers
+    packedAnswersStruct packed;     // Answers packed for the SIMD and pattern kernels
+    int hasStatistics;              // Set when statistics holds the answers' letter statistics
+    answerStatisticsStruct statistics;
+};
+
+
+//-----------------------------------------------------------------------------------------
+// Prepare the answers for the chosen engine: packed for the SIMD comparison kernel and the
+// feedback pattern engines, or summarized into letter statistics.  If the words contain
+// unexpected characters the comparing engines fall back to the original getScore(..).
+void prepareAnswers(
+        preparedAnswersStruct *prepared, // Answers to be prepared
+        wordCountStruct *answerWords,   // Array of the answer words
+        int *answerWeights,             // Weight of each answer, at most MAX_ANSWER_WEIGHT, or NULL
+        int answersWordCount)           // How many words there are in answerWords
+{
+    int isPatternEngine = ScoringEngine == ENGINE_ENTROPY || ScoringEngine == ENGINE_ELIMINATED;
+    memset( prepared, 0, sizeof( preparedAnswersStruct));
+    prepared->answerWords = answerWords;
+    prepared->answerWeights = answerWeights;
+    prepared->answersWordCount = answersWordCount;
+
+    // When the score matrix was built for exactly these answers, just add up its rows
+    // instead of comparing words.  The reference engine always compares.
+    prepared->useMatrix = ! isPatternEngine && ScoreMatrix.rows != NULL && ScoreMatrix.answerWords == answerWords
+                          && answerWeights == NULL && ScoringEngine != ENGINE_REFERENCE;
+    if( isPatternEngine) {
+        packAnswerWords( answerWords, answerWeights, answersWordCount, &prepared->packed);
+        prepared->isPacked = 1;
+    }
+    else if( ! prepared->useMatrix && ScoringEngine == ENGINE_PACKED) {
+        prepared->isPacked = packAnswerWords( answerWords, answerWeights, answersWordCount, &prepared->packed);
+    }
+    else if( ! prepared->useMatrix && ScoringEngine == ENGINE_AGGREGATE) {
+        prepared->hasStatistics = buildAnswerStatistics( answerWords, NULL, answerWeights, answersWordCount,
+                                                         &prepared->statistics);
+    }
+} //end prepareAnswers(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Release the arrays of prepared answers.
+void freePreparedAnswers( preparedAnswersStruct *prepared)
+{
+    freePackedAnswers( &prepared->packed);
+} //end freePreparedAnswers(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Score every word in allWords against the prepared answers, spreading the work across
+// threads with runInParallel(..).  A word appearing more than once in allWords is only
+// scored once.  Returns the highest score.
+int scoreWordsAgainstAnswers(
+        preparedAnswersStruct *prepared, // Answers from prepareAnswers(..)
+        wordCountStruct *allWords,      // Array of all the words
+        int totalWordCount)             // How many words there are in allWords
+{
+    int *firstCopies = getFirstCopies( allWords, totalWordCount);
+    int topScore = INT_MIN;
+
+    // The feedback pattern engines work on tiles of guesses rather than single words
+    if( ScoringEngine == ENGINE_ENTROPY || ScoringEngine == ENGINE_ELIMINATED) {
+        patternJobStruct job = { allWords, firstCopies, totalWordCount, &prepared->packed,
+                                 selectPatternCodeFunction(), ScoringEngine, INT_MIN};
+        int tileCount = (totalWordCount + PATTERN_GUESS_TILE - 1) / PATTERN_GUESS_TILE;
+        runInParallel( tileCount, 1, scorePatternTiles, &job);
+        topScore = job.topScore;
+    }
+    else {
+        scoringJobStruct job = { prepared->answerWords, prepared->answerWeights, prepared->answersWordCount,
+                                 allWords, firstCopies,
+                                 prepared->isPacked ? &prepared->packed : NULL, selectPackedScoreFunction(),
+                                 prepared->hasStatistics ? &prepared->statistics : NULL,
+                                 prepared->useMatrix ? &ScoreMatrix : NULL, INT_MIN};
+        runInParallel( totalWordCount, SCORING_CHUNK_SIZE, scoreWordRange, &job);
+        topScore = job.topScore;
+    }
+
+    // Repeated words get the score of their first copy
+    int repeatCount = 0;
+    for( int i=0; firstCopies != NULL && i<totalWordCount; i++) {
+        if( firstCopies[ i] != i) {
+            allWords[ i].score = allWords[ firstCopies[ i]].score;
+            repeatCount++;
+        }
+    }
+    addToProfileCounter( &Profile.pairsScored, (long) (totalWordCount - repeatCount) * prepared->answersWordCount);
+    return topScore;
+} //end scoreWordsAgainstAnswers(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Score every word in allWords against all of answerWords.  Each answer counts as many
+// times as its weight.  Returns the highest score.
+int scoreAllWords(
+        wordCountStruct *answerWords,   // Array of the answer words
+        int *answerWeights,             // Weight of each answer, at most MAX_ANSWER_WEIGHT, or NULL
+        int answersWordCount,           // How many words there are in answerWords
+        wordCountStruct *allWords,      // Array of all the words
+        int totalWordCount)             // How many words there are in allWords
+{
+    preparedAnswersStruct prepared;
+    prepareAnswers( &prepared, answerWords, answerWeights, answersWordCount);
+    int topScore = scoreWordsAgainstAnswers( &prepared, allWords, totalWordCount);
+    freePreparedAnswers( &prepared);
+    return topScore;
+} //end scoreAllWords(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Everything the threads need to fill in the rows of a new score matrix.
+typedef struct matrixBuildJob matrixBuildJobStruct;
+struct matrixBuildJob{
+    wordCountStruct *allWords;      // Array of all the words, still in the order they were read
+    packedAnswersStruct *packed;    // Packed answers, or NULL if they could not be packed
+    wordCountStruct *answerWords;   // Array of the answer words, used when not packed
+    int answersWordCount;           // How many words there are in answerWords
+    packedScoreFunction packedScore; // Kernel used to compare a guess against packed answers
+    uint8_t *rows;                  // Rows to fill in
+    int rowStride;                  // Bytes per row
+};
+
+
+//-----------------------------------------------------------------------------------------
+// Fill in the score matrix rows start..end-1.
+void buildScoreMatrixRows( void *jobParameter, int start, int end)
+{
+    matrixBuildJobStruct *job = (matrixBuildJobStruct *) jobParameter;
+    for( int i=start; i<end; i++) {
+        uint8_t *row = job->rows + (size_t) i * job->rowStride;
+        packedGuessStruct guess;
+        if( job->packed != NULL && packGuessWord( job->allWords[ i].word, &guess)) {
+            job->packedScore( &guess, job->packed, row);
+        }
+        else {
+            for( int j=0; j<job->rowStride; j++) {
+                row[ j] = 0;
+                if( j < job->answersWordCount) {
+                    row[ j] = (uint8_t) getSingleWordComparisonScore( job->allWords[ i].word, job->answerWords[ j].word);
+                }
+            }
+        }
+    }
+} //end buildScoreMatrixRows(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Hash the contents of a file with 64-bit FNV-1a, continuing from the given hash value.
+uint64_t hashFileContents( char fileName[], uint64_t hash)
+{
+    FILE *inFilePtr = fopen( fileName, "rb");
+    if( inFilePtr == NULL ) {
+        printf("Error: could not open %s for reading\n", fileName);
+        exit(-1);
+    }
+    unsigned char buffer[ 65536];
+    size_t bytesRead;
+    while( (bytesRead = fread( buffer, 1, sizeof( buffer), inFilePtr)) > 0) {
+        for( size_t i=0; i<bytesRead; i++) {
+            hash = (hash ^ buffer[ i]) * 1099511628211ULL;
+        }
+        addToProfileCounter( &Profile.bytesRead, (long) bytesRead);
+    }
+    fclose( inFilePtr);
+    return hash;
+} //end hashFileContents(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Map an existing score matrix file into ScoreMatrix.  Returns 0 if the file is missing,
+// is from a different version, or was built from different answers and guesses files.
+int mapScoreMatrixFile(
+        char fileName[],                // Score matrix file
+        scoreMatrixHeaderStruct *expected) // Header the file must have
+{
+    int fileDescriptor = open( fileName, O_RDONLY);
+    if( fileDescriptor < 0) {
+        return 0;
+    }
+    struct stat fileStatus;
+    size_t expectedSize = sizeof( scoreMatrixHeaderStruct) + (size_t) expected->totalWordCount * expected->rowStride;
+    if( fstat( fileDescriptor, &fileStatus) != 0 || (size_t) fileStatus.st_size != expectedSize) {
+        close( fileDescriptor);
+        return 0;
+    }
+    void *mapped = mmap( NULL, expectedSize, PROT_READ, MAP_SHARED, fileDescriptor, 0);
+    close( fileDescriptor);   // The mapping stays valid after closing
+    if( mapped == MAP_FAILED) {
+        return 0;
+    }
+    if( memcmp( mapped, expected, sizeof( scoreMatrixHeaderStruct)) != 0) {
+        munmap( mapped, expectedSize);
+        return 0;
+    }
+    ScoreMatrix.rows = (uint8_t *) mapped + sizeof( scoreMatrixHeaderStruct);
+    addToProfileCounter( &Profile.bytesRead, (long) expectedSize);
+    return 1;
+} //end mapScoreMatrixFile(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Set up ScoreMatrix for the given words, using the cache file when it matches the current
+// answers and guesses files, and otherwise computing the matrix and (re)writing the file.
+// Must be called before allWords is sorted, since rows follow the order words were read.
+void loadOrBuildScoreMatrix(
+        char matrixFileName[],          // Score matrix cache file
+        char answersFileName[],         // Name of the answers file
+        char guessesFileName[],         // Name of the guesses file
+        wordCountStruct *answerWords,   // Array of the answer words
+        int answersWordCount,           // How many words there are in answerWords
+        wordCountStruct *allWords,      // Array of all the words
+        int totalWordCount)             // How many words there are in allWords
+{
+    scoreMatrixHeaderStruct header;
+    memset( &header, 0, sizeof( header));
+    memcpy( header.magic, SCORE_MATRIX_MAGIC, sizeof( header.magic));
+    header.version = SCORE_MATRIX_VERSION;
+    header.wordLength = WordLength;
+    // Hash both files, with the answers count mixed in between so that moving words from one
+    // file to the other changes the key.
+    header.contentHash = hashFileContents( answersFileName, 14695981039346656037ULL);
+    header.contentHash = (header.contentHash ^ (uint64_t) answersWordCount) * 1099511628211ULL;
+    header.contentHash = hashFileContents( guessesFileName, header.contentHash);
+    header.answersWordCount = answersWordCount;
+    header.totalWordCount = totalWordCount;
+    header.rowStride = (answersWordCount + PACKED_BLOCK_SIZE - 1) / PACKED_BLOCK_SIZE * PACKED_BLOCK_SIZE;
+
+    ScoreMatrix.answerWords = answerWords;
+    ScoreMatrix.answersWordCount = answersWordCount;
+    ScoreMatrix.totalWordCount = totalWordCount;
+    ScoreMatrix.rowStride = header.rowStride;
+    if( mapScoreMatrixFile( matrixFileName, &header)) {
+        return;
+    }
+
+    // Not usable, so compute every row
+    packedAnswersStruct packed = { 0};
+    int isPacked = packAnswerWords( answerWords, NULL, answersWordCount, &packed);
+    ScoreMatrix.rows = (uint8_t *) countedMalloc( (size_t) totalWordCount * header.rowStride);
+    matrixBuildJobStruct job = { allWords, isPacked ? &packed : NULL, answerWords, answersWordCount,
+                                 selectPackedScoreFunction(), ScoreMatrix.rows, header.rowStride};
+    runInParallel( totalWordCount, SCORING_CHUNK_SIZE, buildScoreMatrixRows, &job);
+    freePackedAnswers( &packed);
+
+    // Write to a temporary file first, then rename, so that an interrupted run never leaves
+    // a partial file behind that looks valid.
+    char temporaryFileName[ 1024];
+    snprintf( temporaryFileName, sizeof( temporaryFileName), "%s.tmp", matrixFileName);
+    FILE *outFilePtr = fopen( temporaryFileName, "wb");
+    if( outFilePtr == NULL) {
+        printf("Warning: could not write score matrix file %s\n", matrixFileName);
+        return;
+    }
+    int isWritten = fwrite( &header, sizeof( header), 1, outFilePtr) == 1
+                    && fwrite( ScoreMatrix.rows, header.rowStride, totalWordCount, outFilePtr) == (size_t) totalWordCount;
+    isWritten = fclose( outFilePtr) == 0 && isWritten;
+    if( ! isWritten || rename( temporaryFileName, matrixFileName) != 0) {
+        printf("Warning: could not write score matrix file %s\n", matrixFileName);
+        remove( temporaryFileName);
+    }
+} //end loadOrBuildScoreMatrix(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Restore the heap property below position index of a heap ordered so that the worst word,
+// by compareFunction(..) order, is at the top.
+void siftDownWorstWordHeap( wordCountStruct *heap, int heapSize, int index)
+{
+    while( 1) {
+        int worst = index;
+        int left = 2 * index + 1;
+        int right = left + 1;
+        if( left < heapSize && compareFunction( &heap[ left], &heap[ worst]) > 0) {
+            worst = left;
+        }
+        if( right < heapSize && compareFunction( &heap[ right], &heap[ worst]) > 0) {
+            worst = right;
+        }
+        if( worst == index) {
+            return;
+        }
+        wordCountStruct temporary = heap[ index];
+        heap[ index] = heap[ worst];
+        heap[ worst] = temporary;
+        index = worst;
+    }
+} //end siftDownWorstWordHeap(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Copy the best count words of allWords into bestWords, in the same order a full sort with
+// compareFunction(..) would give them, using a bounded heap rather than sorting allWords.
+// A word in allWords more than once, like the answers that are also in the guesses file, is
+// only kept once.  Returns how many words were stored, which is less than count if there are
+// fewer different words.
+int selectTopWords(
+        wordCountStruct *allWords,      // Array of scored words
+        int totalWordCount,             // How many words there are in allWords
+        int count,                      // How many of the best words are wanted
+        wordCountStruct *bestWords)     // Array with room for count words
+{
+    // Words ever kept in the heap.  A word pushed out of the heap never gets back in, since
+    // only better words replace the worst one, so its copies can be skipped as well.
+    wordTableStruct keptWords;
+    createWordTable( &keptWords, totalWordCount);
+    int heapSize = 0;
+    for( int i=0; i<totalWordCount; i++) {
+        if( heapSize == count && compareFunction( &allWords[ i], &bestWords[ 0]) >= 0) {
+            continue;   // No better than the worst word kept so far
+        }
+        int *keptIndex = findWordInTable( &keptWords, allWords[ i].word);
+        if( *keptIndex >= 0) {
+            continue;   // A copy of a word already kept
+        }
+        *keptIndex = i;
+        if( heapSize < count) {
+            // Still filling up: add at the bottom and move up past any better parents
+            int index = heapSize++;
+            bestWords[ index] = allWords[ i];
+            while( index > 0 && compareFunction( &bestWords[ (index - 1) / 2], &bestWords[ index]) < 0) {
+                wordCountStruct temporary = bestWords[ index];
+                bestWords[ index] = bestWords[ (index - 1) / 2];
+                bestWords[ (index - 1) / 2] = temporary;
+                index = (index - 1) / 2;
+            }
+        }
+        else {
+            // Better than the worst word kept so far, so it replaces it
+            bestWords[ 0] = allWords[ i];
+            siftDownWorstWordHeap( bestWords, heapSize, 0);
+        }
+    }
+    freeWordTable( &keptWords);
+    qsort( bestWords, heapSize, sizeof( wordCountStruct), compareFunction);
+    return heapSize;
+} //end selectTopWords(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Find the score for each word in the allWords array by comparing it against all the words
+// in answerWords and accumulating values for matching letters.
+// Find the number of top-scoring words, returning this value through the reference parameter.
+// With --top N the N best words are returned instead, whether or not their scores are tied.
+// Either way the best words are in descending order by score, then alphabetical order.
+void findScoresAndTopWords(
+        wordCountStruct *answerWords,   // Array of the answer words
+        int *answerWeights,             // Weight of each answer, or NULL for one each
+        int answersWordCount,           // How many words there are in answerWords
+        wordCountStruct *allWords,      // Array of all the words
+        int totalWordCount,             // How many words there are in allWords
+        wordCountStruct * *bestWords,   // Array to be allocated to store best words
+        int *numberOfTopScoringWords)   // How many best words were stored
+{
+    // For each word in the allWords array, calculate its score to represent how good of a job
+    // it does on average at matching letters from the answer words.  The struct used to
+    // store words has space for the 5-letter word as well as for that word's score.
+    // The words are scored in parallel, see scoreAllWords(..), which also finds the top score.
+    char phaseName[ 128];
+    struct timespec phaseStart;
+    startProfilePhase( &phaseStart);
+    int topScore = scoreAllWords( answerWords, answerWeights, answersWordCount, allWords, totalWordCount);
+    snprintf( phaseName, sizeof( phaseName), "%s: scoring", ProfilePassName);
+    endProfilePhase( phaseName, &phaseStart);
+    startProfilePhase( &phaseStart);
+
+    // Only the best words are needed, so rather than sorting all of allWords either keep the
+    // N best with a bounded heap, or pick out the words sharing the top score and sort those.
+    if( TopWordsCount > 0) {
+        *bestWords = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * TopWordsCount);
+        *numberOfTopScoringWords = selectTopWords( allWords, totalWordCount, TopWordsCount, *bestWords);
+    }
+    else {
+        // Count the number of words that all share that top score.
+        int topCount = 0;
+        for( int i=0; i<totalWordCount; i++) {
+            topCount += allWords[ i].score == topScore;
+        }
+        *numberOfTopScoringWords = topCount;
+
+        // Allocate memory for the best words array and store words into it, in alphabetical order.
+        *bestWords = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * topCount);
+        int index = 0;
+        for( int i=0; i<totalWordCount; i++) {
+            if( allWords[ i].score == topScore) {
+                (*bestWords)[ index++] = allWords[ i];   // Store
+            }
+        }
+        qsort( *bestWords, topCount, sizeof( wordCountStruct), compareFunction);
+    }
+    snprintf( phaseName, sizeof( phaseName), "%s: top word selection", ProfilePassName);
+    endProfilePhase( phaseName, &phaseStart);
+
+    // For debugging set global value DebugOn to 1
+    if( DebugOn) {
+        // Sort the allWords array in descending order by score, and within score alphabetically.
+        qsort( allWords, totalWordCount, sizeof( wordCountStruct), compareFunction);
+        // For debugging display all words in descending order
+        printf("All words in descending order by score:\n");
+        for (int i = 0; i < totalWordCount; i++) {
+            printf("%d %s\n", allWords[ i].score, allWords[ i].word);   // Display
+        }
+    }
+    
+    if( DebugOn) {
+        // For debugging display the top scoring words
+        printf("Top scoring words:\n");
+        for (int i = 0; i < *numberOfTopScoringWords; i++) {
+            printf("%s %d\n", (*bestWords)[i].word, (*bestWords)[i].score);   // Display
+        }
+    }
+} //end findScoresAndTopWords(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Remove from a single answer word the letters that were already handled with the bestWord.
+void removeMatchingLettersFromWord(
+        char answerWord[],                // Answer word, letters are blanked out in place
+        char bestWord[ ])                 // The best word
+{
+    Kernels->removeMatchingLetters( answerWord, bestWord);
+} //end removeMatchingLettersFromWord(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Go through the array of answerWordsCopy.  For each word, remove the letters that were already
+// handled with the bestWord, so we are only scoring on letters from the second move and
+// not (again) from first move letters represented by bestWord.
+void removeMatchingLetters(
+        wordCountStruct *answerWordsCopy, // Copy of the answerWords
+        int answersWordCount,             // How many words in the allWords array
+        char bestWord[ ])                 // The best word
+{
+    // Go through each word in answerWordsCopy
+    for( int i=0; i<answersWordCount; i++) {
+        removeMatchingLettersFromWord( answerWordsCopy[ i].word, bestWord);
+    }
+} //end removeMatchingLetters(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Same as removeMatchingLettersFromWord(..), but with the answer's blanked-out letters kept as a
+// bit mask next to the unchanged answer word.  Returns the new mask.
+uint8_t removeMatchingLettersFromMask(
+        char answerWord[],                // Unchanged answer word
+        uint8_t blankedMask,              // Bit j set when letter j is already blanked out
+        char bestWord[ ])                 // The best word
+{
+    char answerWordCopy[ MAX_WORD_LENGTH + 1];
+    strcpy( answerWordCopy, answerWord);
+    for( int j=0; j<WordLength; j++) {
+        if( blankedMask >> j & 1) {
+            answerWordCopy[ j] = ' ';
+        }
+    }
+    removeMatchingLettersFromWord( answerWordCopy, bestWord);
+
+    uint8_t newMask = 0;
+    for( int j=0; j<WordLength; j++) {
+        if( answerWordCopy[ j] == ' ') {
+            newMask |= 1 << j;
+        }
+    }
+    return newMask;
+} //end removeMatchingLettersFromMask(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Put one copy of each different answer into uniqueAnswers, with how many times it appears
+// in answerWords as its weight.  Once the first word's letters are removed many answers are
+// left with the same letters in the same places, and those score the same against any guess,
+// so each only needs scoring once.  Groups bigger than MAX_ANSWER_WEIGHT are split.
+// Returns how many unique answers there are.
+int groupIdenticalAnswers(
+        wordCountStruct *answerWords,   // Answer words, possibly with letters blanked out
+        int answersWordCount,           // How many words there are in answerWords
+        wordCountStruct *uniqueAnswers, // Room for answersWordCount words, filled in
+        int *answerWeights)             // Room for answersWordCount weights, filled in
+{
+    wordTableStruct table;
+    createWordTable( &table, answersWordCount);
+    int uniqueCount = 0;
+    for( int i=0; i<answersWordCount; i++) {
+        int *group = findWordInTable( &table, answerWords[ i].word);
+        if( *group < 0 || answerWeights[ *group] == MAX_ANSWER_WEIGHT) {
+            *group = uniqueCount;
+            uniqueAnswers[ uniqueCount] = answerWords[ i];
+            answerWeights[ uniqueCount++] = 0;
+        }
+        answerWeights[ *group]++;
+    }
+    freeWordTable( &table);
+    return uniqueCount;
+} //end groupIdenticalAnswers(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Copy answerWords into answerWordsCopy with the letters of bestWord removed, then group the
+// copies that are left identical into uniqueAnswers and answerWeights, see groupIdenticalAnswers(..).
+// Returns how many unique answers there are.
+int getResidualAnswers(
+        wordCountStruct *answerWords,   // The set of answer words
+        int answersWordCount,           // How many answer words there are
+        char bestWord[],                // The first word
+        wordCountStruct *answerWordsCopy, // Room for answersWordCount words, filled in
+        wordCountStruct *uniqueAnswers, // Room for answersWordCount words, filled in
+        int *answerWeights)             // Room for answersWordCount weights, filled in
+{
+    // Make a copy of answerWords, zeroing out its scores and eliminating the first occurrence
+    // of all characters found in the current top-scoring word.
+    // Copy the original words into answerWordsCopy, and zero-out scores in the copy
+    for( int j=0; j<answersWordCount; j++) {
+        strcpy( answerWordsCopy[ j].word, answerWords[ j].word);
+        answerWordsCopy[ j].score = 0;
+    }
+
+    // Remove single letters matching those in the current best word under consideration
+    removeMatchingLetters( answerWordsCopy, answersWordCount, bestWord);
+
+    // Answers left with identical letters are scored once, weighted by how many there are
+    return groupIdenticalAnswers( answerWordsCopy, answersWordCount, uniqueAnswers, answerWeights);
+} //end getResidualAnswers(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Find the best second words for the given first word, using answerWordsCopy as space for
+// the answers with the first word's letters removed.
+void findBestSecondWords(
+        wordCountStruct *answerWords,   // The set of answer words
+        int answersWordCount,           // How many answer words there are
+        wordCountStruct *allWords,      // The set of all words
+        int totalWordCount,             // How many allWords there are
+        char bestWord[],                // The first word
+        wordCountStruct *answerWordsCopy, // Room for answersWordCount words, filled in
+        wordCountStruct * *bestSecondWords, // Array to be allocated to store best second words
+        int *numberOfTopScoringSecondWords) // How many best second words were stored
+{
+    char savedPassName[ sizeof( ProfilePassName)];
+    strcpy( savedPassName, ProfilePassName);
+    snprintf( ProfilePassName, sizeof( ProfilePassName), "second-word pass after %s", bestWord);
+    struct timespec phaseStart;
+    startProfilePhase( &phaseStart);
+    wordCountStruct *uniqueAnswers = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * answersWordCount);
+    int *answerWeights = (int *) countedMalloc( sizeof( int) * answersWordCount);
+    int uniqueCount = getResidualAnswers( answerWords, answersWordCount, bestWord,
+                                          answerWordsCopy, uniqueAnswers, answerWeights);
+    char phaseName[ 128];
+    snprintf( phaseName, sizeof( phaseName), "%s: residual answers", ProfilePassName);
+    endProfilePhase( phaseName, &phaseStart);
+
+    // For each word in allWords find its score by comparing to all answerWordsCopy.
+    // Sort and find top scoring words.
+    findScoresAndTopWords( uniqueAnswers, answerWeights, uniqueCount,
+                           allWords, totalWordCount,
+                           bestSecondWords, numberOfTopScoringSecondWords);
+    free( uniqueAnswers);
+    free( answerWeights);
+    strcpy( ProfilePassName, savedPassName);
+} //end findBestSecondWords(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Display a first word and its score, then its best second words and their scores.
+void displayBestSecondWords(
+        char bestWord[],                // The first word
+        int bestWordScore,              // Score of the first word
+        wordCountStruct *bestSecondWords, // The best second words
+        int numberOfTopScoringSecondWords) // How many best second words there are
+{
+    printf("%s %d\n", bestWord, bestWordScore);
+    for (int i = 0; i < numberOfTopScoringSecondWords; i++) {
+        printf("   %s %d", bestSecondWords[i].word, bestSecondWords[i].score);
+    }
+    printf("\n");
+} //end displayBestSecondWords(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Find the set of best second words, once the letters from the first words are taken out
+// of the way.
+void findAndDisplayBestSecondWords(
+        wordCountStruct *answerWords,   // The set of answer words
+        int answersWordCount,           // How many answer words there are
+        wordCountStruct *allWords,      // The set of all words
+        int totalWordCount,             // How many allWords there are
+        wordCountStruct *bestWords,     // The set of best first words
+        int bestWordIndex)              // Index of current best word being used to find best
+                                        //   second words.
+{
+    char bestWord[ 81];        // The best first word used this round to find best second words.
+    strcpy( bestWord, bestWords[ bestWordIndex].word);
+    int bestWordScore = bestWords[ bestWordIndex].score;
+
+    // First allocate space for the copy of answerWords.
+    wordCountStruct *answerWordsCopy = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * answersWordCount);
+
+    // Find the top scoring words once the letters of the best word are removed
+    int numberOfTopScoringSecondWords = 0;
+    wordCountStruct *bestSecondWords = NULL;  // Will be allocated in function below
+    findBestSecondWords( answerWords, answersWordCount, allWords, totalWordCount, bestWord,
+                         answerWordsCopy, &bestSecondWords, &numberOfTopScoringSecondWords);
+
+    if( DebugOn) {
+        // For debugging display allWordsCopy, with letters from bestWord removed
+        printf("answerWordsCopy after letters from %s removed:\n", bestWord);
+        for (int j = 0; j < answersWordCount; j++) {
+            printf("%2d. %s\n", j, answerWordsCopy[j].word);
+        }
+
+        // For debugging display all words and scores
+        printf("    Words and scores:\n");
+        for (int i = 0; i < totalWordCount; i++) {
+            printf("    %s %d \n", allWords[i].word, allWords[i].score);
+        }
+    } //end if( DebugOn)
+
+    // Display the top scoring first and second words
+    displayBestSecondWords( bestWord, bestWordScore, bestSecondWords, numberOfTopScoringSecondWords);
+    free( answerWordsCopy);
+    free( bestSecondWords);
+} //end findAndDisplayBestSecondWords(..)
+
+
+// -----------------------------------------------------------------------------------------
+// State shared by the tasks finding the best second words for the best first words.  Each
+// first word is one task, scoring its own copy of allWords, and the results are displayed in
+// the order of the first words as soon as all the ones before them are done, or else kept.
+typedef struct secondWordSearch secondWordSearchStruct;
+struct secondWordSearch{
+    wordCountStruct *answerWords;   // The set of answer words
+    int answersWordCount;           // How many answer words there are
+    wordCountStruct *allWords;      // The set of all words, copied by each task
+    int totalWordCount;             // How many allWords there are
+    wordCountStruct *bestWords;     // The best first words, one task each
+    int threadsPerTask;             // Threads each task may use for its own scoring
+    pthread_mutex_t displayLock;    // Protects the results and nextToDisplay
+    wordCountStruct * *bestSecondWords; // Best second words found by each task, until displayed
+    int *secondWordCounts;          // How many best second words each task found
+    int *isDone;                    // Set when a task's result is ready
+    int nextToDisplay;              // First task whose result has not been displayed yet
+    int taskCount;                  // How many tasks there are
+    int isDisplayed;                // Set to display and free the results, otherwise they are kept
+    double *taskSeconds;            // How long each task took, added to the profile at the end
+};
+
+
+// -----------------------------------------------------------------------------------------
+// Find the best second words for the first words start..end-1, then display every result
+// that is next in line if the results are displayed.
+void findSecondWordsForFirstWords( void *searchParameter, int start, int end)
+{
+    secondWordSearchStruct *search = (secondWordSearchStruct *) searchParameter;
+    int savedTaskThreadCount = TaskThreadCount;
+    TaskThreadCount = search->threadsPerTask;
+    wordCountStruct *scoredWords = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * search->totalWordCount);
+    wordCountStruct *answerWordsCopy = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * search->answersWordCount);
+    memcpy( scoredWords, search->allWords, sizeof( wordCountStruct) * search->totalWordCount);
+
+    for( int task=start; task<end; task++) {
+        struct timespec taskStart;
+        startProfilePhase( &taskStart);
+        int numberOfTopScoringSecondWords = 0;
+        wordCountStruct *bestSecondWords = NULL;  // Will be allocated in function below
+        findBestSecondWords( search->answerWords, search->answersWordCount, scoredWords, search->totalWordCount,
+                             search->bestWords[ task].word, answerWordsCopy,
+                             &bestSecondWords, &numberOfTopScoringSecondWords);
+        if( ProfileOn) {
+            search->taskSeconds[ task] = getElapsedSeconds( &taskStart);
+        }
+
+        pthread_mutex_lock( &search->displayLock);
+        search->bestSecondWords[ task] = bestSecondWords;
+        search->secondWordCounts[ task] = numberOfTopScoringSecondWords;
+        search->isDone[ task] = 1;
+        while( search->isDisplayed && search->nextToDisplay < search->taskCount && search->isDone[ search->nextToDisplay]) {
+            int next = search->nextToDisplay++;
+            displayBestSecondWords( search->bestWords[ next].word, search->bestWords[ next].score,
+                                    search->bestSecondWords[ next], search->secondWordCounts[ next]);
+            free( search->bestSecondWords[ next]);
+        }
+        fflush( stdout);
+        pthread_mutex_unlock( &search->displayLock);
+    }
+
+    free( scoredWords);
+    free( answerWordsCopy);
+    TaskThreadCount = savedTaskThreadCount;
+} //end findSecondWordsForFirstWords(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Find the best second words for each of the best first words, each first word as a separate
+// task, with the scoring threads shared out between the tasks, so many tied first words take
+// about as long as a few.  If isDisplayed is set each result is displayed as soon as it is
+// next in line, otherwise the results are left in search->bestSecondWords and
+// search->secondWordCounts.  The caller frees those two arrays, and the results that were kept.
+void findAllBestSecondWords(
+        secondWordSearchStruct *search, // Search to be set up and run
+        wordCountStruct *answerWords,   // The set of answer words
+        int answersWordCount,           // How many answer words there are
+        wordCountStruct *allWords,      // The set of all words
+        int totalWordCount,             // How many allWords there are
+        wordCountStruct *bestWords,     // The set of best first words
+        int numberOfTopScoringWords,    // How many best first words there are
+        int isDisplayed)                // Set to display the results rather than keep them
+{
+    memset( search, 0, sizeof( secondWordSearchStruct));
+    search->answerWords = answerWords;
+    search->answersWordCount = answersWordCount;
+    search->allWords = allWords;
+    search->totalWordCount = totalWordCount;
+    search->bestWords = bestWords;
+    search->threadsPerTask = getScoringThreadCount() / numberOfTopScoringWords;
+    if( search->threadsPerTask < 1) {
+        search->threadsPerTask = 1;
+    }
+    pthread_mutex_init( &search->displayLock, NULL);
+    search->bestSecondWords = (wordCountStruct * *) countedMalloc( sizeof( wordCountStruct *) * numberOfTopScoringWords);
+    search->secondWordCounts = (int *) countedMalloc( sizeof( int) * numberOfTopScoringWords);
+    search->isDone = (int *) countedCalloc( numberOfTopScoringWords, sizeof( int));
+    search->taskSeconds = (double *) countedCalloc( numberOfTopScoringWords, sizeof( double));
+    search->taskCount = numberOfTopScoringWords;
+    search->isDisplayed = isDisplayed;
+
+    struct timespec phaseStart;
+    startProfilePhase( &phaseStart);
+    runInParallel( numberOfTopScoringWords, 1, findSecondWordsForFirstWords, search);
+    endProfilePhase( "second-word passes", &phaseStart);
+
+    // Each pass as a whole, since the phases within the tasks were not recorded.  The passes
+    // ran at the same time, so together they can take longer than all the second-word passes.
+    char phaseName[ 128];
+    for( int task=0; task<numberOfTopScoringWords; task++) {
+        snprintf( phaseName, sizeof( phaseName), "second-word pass after %s", bestWords[ task].word);
+        addProfilePhase( phaseName, search->taskSeconds[ task]);
+    }
+
+    pthread_mutex_destroy( &search->displayLock);
+    free( search->isDone);
+    free( search->taskSeconds);
+} //end findAllBestSecondWords(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Find and display the best second words for each of the best first words.  When there is
+// more than one first word each is searched as a separate task, see findAllBestSecondWords(..).
+void findAndDisplayAllBestSecondWords(
+        wordCountStruct *answerWords,   // The set of answer words
+        int answersWordCount,           // How many answer words there are
+        wordCountStruct *allWords,      // The set of all words
+        int totalWordCount,             // How many allWords there are
+        wordCountStruct *bestWords,     // The set of best first words
+        int numberOfTopScoringWords)    // How many best first words there are
+{
+    // The debugging output of each search has to come out in one piece
+    if( DebugOn || numberOfTopScoringWords < 2) {
+        for( int i=0; i<numberOfTopScoringWords; i++) {
+            findAndDisplayBestSecondWords( answerWords, answersWordCount, allWords, totalWordCount, bestWords, i);
+        }
+        return;
+    }
+
+    secondWordSearchStruct search;
+    findAllBestSecondWords( &search, answerWords, answersWordCount, allWords, totalWordCount,
+                            bestWords, numberOfTopScoringWords, 1);
+    free( search.bestSecondWords);
+    free( search.secondWordCounts);
+} //end findAndDisplayAllBestSecondWords(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Remove the repeats of words from an array sorted with compareFunction(..), keeping the
+// order of the rest.  Returns how many different words are left.
+int removeRepeatedWords(
+        wordCountStruct *words,         // Sorted array of scored words, changed in place
+        int wordCount)                  // How many words there are in words
+{
+    // Duplicates have the same score, so they are next to each other after sorting
+    int distinctCount = 0;
+    for( int i=0; i<wordCount; i++) {
+        if( distinctCount == 0 || strcmp( words[ distinctCount - 1].word, words[ i].word) != 0) {
+            words[ distinctCount++] = words[ i];
+        }
+    }
+    return distinctCount;
+} //end removeRepeatedWords(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Copy the words of allWords, each word only once, into a new array sorted in descending
+// order by score and then alphabetically.  Returns how many distinct words there are.
+int getDistinctWordsByScore(
+        wordCountStruct *allWords,      // Array of scored words, possibly with duplicates
+        int totalWordCount,             // How many words there are in allWords
+        wordCountStruct * *distinctWords) // Array to be allocated to store the distinct words
+{
+    *distinctWords = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * totalWordCount);
+    memcpy( *distinctWords, allWords, sizeof( wordCountStruct) * totalWordCount);
+    qsort( *distinctWords, totalWordCount, sizeof( wordCountStruct), compareFunction);
+    return removeRepeatedWords( *distinctWords, totalWordCount);
+} //end getDistinctWordsByScore(..)
+
+
+// -----------------------------------------------------------------------------------------
+// A first and second word pair found by the exhaustive pair search.
+typedef struct wordPair wordPairStruct;
+struct wordPair{
+    int firstIndex;             // Index of the first word in the candidate words
+    int secondIndex;            // Index of the second word in the candidate words
+    int secondScore;            // Score of the second word once the first word's letters are removed
+};
+
+// Buffers a thread needs while trying second words for a first word.  They are handed from
+// one first word to the next rather than allocated for each one.
+typedef struct pairScratch pairScratchStruct;
+struct pairScratch{
+    wordCountStruct *answerWordsCopy; // Room for the answers with a first word's letters removed
+    wordPairStruct *pairs;          // Room for a first word's best pairs, one per candidate word
+    pairScratchStruct *next;        // Next buffers not in use, when in the spare list
+};
+
+// State shared by the threads of the exhaustive pair search.  Each first word is one work item.
+typedef struct pairSearch pairSearchStruct;
+struct pairSearch{
+    wordCountStruct *answerWords;   // Array of the answer words
+    int answersWordCount;           // How many words there are in answerWords
+    wordCountStruct *words;         // Candidate words, distinct, in descending order by first-word score
+    int wordCount;                  // How many candidate words there are
+    answerStatisticsStruct *answerStatistics; // Letter statistics of the unchanged answers
+    int bestTotal;                  // Best pair total so far, read without locking for pruning
+    pthread_mutex_t bestPairsLock;  // Protects bestPairs and bestPairCount
+    wordPairStruct *bestPairs;      // Pairs that reach bestTotal
+    int bestPairCount;              // How many pairs are in bestPairs
+    int bestPairCapacity;           // Room in bestPairs
+    long pairsEvaluated;            // Pairs whose exact score was computed
+    long pairsPruned;               // Pairs skipped because their upper bound was below bestTotal
+    pthread_mutex_t scratchLock;    // Protects spareScratch
+    pairScratchStruct *spareScratch; // Buffers not in use by any thread, at most one set per thread
+};
+
+
+// -----------------------------------------------------------------------------------------
+// Record pairs reaching the given total, replacing the best pairs if the total is higher.
+void addBestPairs( pairSearchStruct *search, int total, wordPairStruct *pairs, int pairCount)
+{
+    pthread_mutex_lock( &search->bestPairsLock);
+    if( total > search->bestTotal) {
+        search->bestPairCount = 0;
+        __atomic_store_n( &search->bestTotal, total, __ATOMIC_RELAXED);
+    }
+    if( total == search->bestTotal) {
+        if( search->bestPairCount + pairCount > search->bestPairCapacity) {
+            search->bestPairCapacity = 2 * (search->bestPairCount + pairCount);
+            search->bestPairs = (wordPairStruct *) countedRealloc( search->bestPairs, sizeof( wordPairStruct) * search->bestPairCapacity);
+        }
+        memcpy( &search->bestPairs[ search->bestPairCount], pairs, sizeof( wordPairStruct) * pairCount);
+        search->bestPairCount += pairCount;
+    }
+    pthread_mutex_unlock( &search->bestPairsLock);
+} //end addBestPairs(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Evaluate every second word for the first words start..end-1.  The second word score can only
+// go down when letters are blanked out, so first score + second word's own first-word score
+// is an upper bound on a pair's total.  Candidate words are in descending order by score, so
+// once that bound falls below the best total every remaining second word can be skipped.
+// A second word letter in the same position as the first word's letter also loses the 2 exact
+// match points for every answer with that letter there, tightening the bound further.
+void searchPairsForFirstWords( void *searchParameter, int start, int end)
+{
+    pairSearchStruct *search = (pairSearchStruct *) searchParameter;
+    wordCountStruct *words = search->words;
+    pairScratchStruct *scratch = NULL;  // Taken once a first word is not pruned
+    wordCountStruct *answerWordsCopy = NULL;
+    wordPairStruct *pairs = NULL;
+    long evaluated = 0;
+    long pruned = 0;
+
+    for( int first=start; first<end; first++) {
+        int firstScore = words[ first].score;
+        int bestSecondPossible = words[ first == 0 ? 1 : 0].score;
+        if( firstScore + bestSecondPossible < __atomic_load_n( &search->bestTotal, __ATOMIC_RELAXED)) {
+            pruned += search->wordCount - 1;
+            continue;
+        }
+        if( scratch == NULL) {
+            // Reuse the buffers another first word has finished with, if there are any
+            pthread_mutex_lock( &search->scratchLock);
+            scratch = search->spareScratch;
+            if( scratch != NULL) {
+                search->spareScratch = scratch->next;
+            }
+            pthread_mutex_unlock( &search->scratchLock);
+            if( scratch == NULL) {
+                scratch = (pairScratchStruct *) countedMalloc( sizeof( pairScratchStruct));
+                scratch->answerWordsCopy = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * search->answersWordCount);
+                scratch->pairs = (wordPairStruct *) countedMalloc( sizeof( wordPairStruct) * search->wordCount);
+            }
+            answerWordsCopy = scratch->answerWordsCopy;
+            pairs = scratch->pairs;
+        }
+
+        // Letter statistics of the answers once this first word's letters are removed
+        memcpy( answerWordsCopy, search->answerWords, sizeof( wordCountStruct) * search->answersWordCount);
+        removeMatchingLetters( answerWordsCopy, search->answersWordCount, words[ first].word);
+        answerStatisticsStruct residualStatistics;
+        buildAnswerStatistics( answerWordsCopy, NULL, NULL, search->answersWordCount, &residualStatistics);
+
+        int localBest = -1;
+        int pairCount = 0;
+        for( int second=0; second<search->wordCount; second++) {
+            if( second == first) {
+                continue;
+            }
+            int bestTotal = __atomic_load_n( &search->bestTotal, __ATOMIC_RELAXED);
+            if( localBest > bestTotal) {
+                bestTotal = localBest;
+            }
+            if( firstScore + words[ second].score < bestTotal) {
+                pruned += search->wordCount - second - (first > second ? 1 : 0);
+                break;
+            }
+
+            int overlapPenalty = 0;
+            for( int j=0; j<WordLength; j++) {
+                if( words[ second].word[ j] == words[ first].word[ j]) {
+                    overlapPenalty += 2 * search->answerStatistics->positionCounts[ j][ words[ first].word[ j] - 'a'];
+                }
+            }
+            if( firstScore + words[ second].score - overlapPenalty < bestTotal) {
+                pruned++;
+                continue;
+            }
+
+            packedGuessStruct guess;
+            packGuessWord( words[ second].word, &guess);
+            int secondScore = getAggregateScore( &guess, &residualStatistics);
+            evaluated++;
+            if( firstScore + secondScore > localBest) {
+                localBest = firstScore + secondScore;
+                pairCount = 0;
+            }
+            if( firstScore + secondScore == localBest) {
+                pairs[ pairCount].firstIndex = first;
+                pairs[ pairCount].secondIndex = second;
+                pairs[ pairCount].secondScore = secondScore;
+                pairCount++;
+            }
+        }
+        if( pairCount > 0 && localBest >= __atomic_load_n( &search->bestTotal, __ATOMIC_RELAXED)) {
+            addBestPairs( search, localBest, pairs, pairCount);
+        }
+    }
+
+    __atomic_fetch_add( &search->pairsEvaluated, evaluated, __ATOMIC_RELAXED);
+    __atomic_fetch_add( &search->pairsPruned, pruned, __ATOMIC_RELAXED);
+    addToProfileCounter( &Profile.pairsScored, evaluated * search->answersWordCount);
+    if( scratch != NULL) {
+        pthread_mutex_lock( &search->scratchLock);
+        scratch->next = search->spareScratch;
+        search->spareScratch = scratch;
+        pthread_mutex_unlock( &search->scratchLock);
+    }
+} //end searchPairsForFirstWords(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Comparator for qsort(..) putting best pairs in order of their first word, then their second
+// word, each in the order of the candidate words (descending score, then alphabetical).
+int comparePairs( const void *a, const void *b)
+{
+    wordPairStruct *firstPair = (wordPairStruct *) a;
+    wordPairStruct *secondPair = (wordPairStruct *) b;
+    if( firstPair->firstIndex != secondPair->firstIndex) {
+        return firstPair->firstIndex - secondPair->firstIndex;
+    }
+    return firstPair->secondIndex - secondPair->secondIndex;
+} //end comparePairs(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Find the best first and second word pair over all pairs of words, rather than only
+// trying second words for the best first words.  A pair's total is the first word's score
+// plus the second word's score once the first word's letters are removed from the answers
+// the same way removeMatchingLetters(..) does.  Uses branch-and-bound with the aggregate
+// letter statistics, so most pairs are never evaluated.  The best pairs are left in search,
+// in comparePairs(..) order, as indexes into the candidate words.  Returns how many candidate
+// words there are, fewer than 2 meaning there are no pairs.
+int findBestPairs(
+        wordCountStruct *answerWords,   // The set of answer words
+        int answersWordCount,           // How many answer words there are
+        wordCountStruct *allWords,      // The set of all words
+        int totalWordCount,             // How many allWords there are
+        pairSearchStruct *search,       // Search results, to be filled in
+        wordCountStruct * *words)       // Candidate words, to be allocated
+{
+    // Score every word as a first word, and keep one copy of each word in score order
+    answerStatisticsStruct answerStatistics;
+    buildAnswerStatistics( answerWords, NULL, NULL, answersWordCount, &answerStatistics);
+    for( int i=0; i<totalWordCount; i++) {
+        packedGuessStruct guess;
+        packGuessWord( allWords[ i].word, &guess);
+        allWords[ i].score = getAggregateScore( &guess, &answerStatistics);
+    }
+    int wordCount = getDistinctWordsByScore( allWords, totalWordCount, words);
+    memset( search, 0, sizeof( pairSearchStruct));
+    if( wordCount < 2) {
+        return wordCount;
+    }
+
+    search->answerWords = answerWords;
+    search->answersWordCount = answersWordCount;
+    search->words = *words;
+    search->wordCount = wordCount;
+    search->answerStatistics = &answerStatistics;
+    search->bestTotal = -1;
+    pthread_mutex_init( &search->bestPairsLock, NULL);
+    pthread_mutex_init( &search->scratchLock, NULL);
+
+    // One first word per work item, taken in descending score order so good pairs are found
+    // early and the bound prunes as much as possible.
+    runInParallel( wordCount, 1, searchPairsForFirstWords, search);
+
+    // Pairs with the best total are never pruned, so the list of ties is complete
+    qsort( search->bestPairs, search->bestPairCount, sizeof( wordPairStruct), comparePairs);
+    pthread_mutex_destroy( &search->bestPairsLock);
+    pthread_mutex_destroy( &search->scratchLock);
+    while( search->spareScratch != NULL) {
+        pairScratchStruct *scratch = search->spareScratch;
+        search->spareScratch = scratch->next;
+        free( scratch->answerWordsCopy);
+        free( scratch->pairs);
+        free( scratch);
+    }
+    search->answerStatistics = NULL;    // Only valid during the search
+    return wordCount;
+} //end findBestPairs(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Find and display the best first and second word pairs, see findBestPairs(..).
+void findAndDisplayBestPairs(
+        wordCountStruct *answerWords,   // The set of answer words
+        int answersWordCount,           // How many answer words there are
+        wordCountStruct *allWords,      // The set of all words
+        int totalWordCount)             // How many allWords there are
+{
+    pairSearchStruct search;
+    wordCountStruct *words = NULL;
+    int wordCount = findBestPairs( answerWords, answersWordCount, allWords, totalWordCount, &search, &words);
+    if( wordCount < 2) {
+        printf("At least two different words are needed to search for pairs\n");
+        free( words);
+        return;
+    }
+
+    if( OutputFormat == FORMAT_JSON) {
+        printf("{\"query\":\"pairs\",\"total\":%d,\"pairs\":[", search.bestTotal);
+        for( int i=0; i<search.bestPairCount; i++) {
+            wordPairStruct *pair = &search.bestPairs[ i];
+            printf("%s{\"first\":\"%s\",\"firstScore\":%d,\"second\":\"%s\",\"secondScore\":%d}", i > 0 ? "," : "",
+                   words[ pair->firstIndex].word, words[ pair->firstIndex].score,
+                   words[ pair->secondIndex].word, pair->secondScore);
+        }
+        printf("],\"evaluated\":%ld,\"pruned\":%ld}\n", search.pairsEvaluated, search.pairsPruned);
+    }
+    else {
+        printf("Best first and second word pairs over all %ld pairs:\n", (long) wordCount * (wordCount - 1));
+        for( int i=0; i<search.bestPairCount; i++) {
+            wordPairStruct *pair = &search.bestPairs[ i];
+            printf("%s %d\n   %s %d   total %d\n", words[ pair->firstIndex].word, words[ pair->firstIndex].score,
+                   words[ pair->secondIndex].word, pair->secondScore, search.bestTotal);
+        }
+        printf("Pairs evaluated: %ld, pruned: %ld\n", search.pairsEvaluated, search.pairsPruned);
+    }
+
+    free( search.bestPairs);
+    free( words);
+} //end findAndDisplayBestPairs(..)
+
+
+// -----------------------------------------------------------------------------------------
+// One sequence of opening words kept in the beam search.
+typedef struct beamEntry beamEntryStruct;
+struct beamEntry{
+    char words[ MAX_BEAM_DEPTH][ MAX_WORD_LENGTH + 1]; // The words of the sequence, in order
+    int scores[ MAX_BEAM_DEPTH];    // Score of each word once the letters of earlier words are removed
+    int length;                     // How many words there are in the sequence
+    int total;                      // Sum of the scores
+    int parent;                     // Entry in the previous beam that this sequence extends
+};
+
+// State shared by the threads extending the beam by one word.  Each beam entry is one work item.
+typedef struct beamStep beamStepStruct;
+struct beamStep{
+    wordCountStruct *answerWords;   // Array of the unchanged answer words
+    int answersWordCount;           // How many words there are in answerWords
+    wordCountStruct *words;         // Candidate words, each word once
+    int wordCount;                  // How many candidate words there are
+    beamEntryStruct *beam;          // Current beam
+    uint8_t *blankedMasks;          // answersWordCount blanked-letter masks per beam entry
+    beamEntryStruct *candidates;    // BeamWidth extensions per beam entry, to be filled in
+    int *candidateCounts;           // How many extensions were stored for each beam entry
+};
+
+
+// -----------------------------------------------------------------------------------------
+// Comparator for qsort(..) putting beam entries in descending order by total, and sequences
+// with the same total in alphabetical order word by word.
+int compareBeamEntries( const void *a, const void *b)
+{
+    beamEntryStruct *first = (beamEntryStruct *) a;
+    beamEntryStruct *second = (beamEntryStruct *) b;
+    if( first->total != second->total) {
+        return second->total - first->total;
+    }
+    for( int i=0; i<first->length && i<second->length; i++) {
+        int comparison = strcmp( first->words[ i], second->words[ i]);
+        if( comparison != 0) {
+            return comparison;
+        }
+    }
+    return first->length - second->length;
+} //end compareBeamEntries(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Extend the beam entries start..end-1 by every candidate word not already in the sequence,
+// keeping the BeamWidth best extensions of each.  The answers with the entry's letters
+// removed are summarized into letter statistics, so every candidate word costs O(1).
+void extendBeamEntries( void *stepParameter, int start, int end)
+{
+    beamStepStruct *step = (beamStepStruct *) stepParameter;
+    wordCountStruct *scoredWords = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * step->wordCount);
+    wordCountStruct *bestWords = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * BeamWidth);
+
+    for( int entry=start; entry<end; entry++) {
+        beamEntryStruct *parent = &step->beam[ entry];
+        answerStatisticsStruct statistics;
+        buildAnswerStatistics( step->answerWords, &step->blankedMasks[ (size_t) entry * step->answersWordCount],
+                               NULL, step->answersWordCount, &statistics);
+
+        int scoredCount = 0;
+        for( int i=0; i<step->wordCount; i++) {
+            int isInSequence = 0;
+            for( int j=0; j<parent->length; j++) {
+                isInSequence |= strcmp( parent->words[ j], step->words[ i].word) == 0;
+            }
+            if( ! isInSequence) {
+                packedGuessStruct guess;
+                packGuessWord( step->words[ i].word, &guess);
+                scoredWords[ scoredCount] = step->words[ i];
+                scoredWords[ scoredCount].score = getAggregateScore( &guess, &statistics);
+                scoredCount++;
+            }
+        }
+
+        int bestCount = selectTopWords( scoredWords, scoredCount, BeamWidth, bestWords);
+        for( int i=0; i<bestCount; i++) {
+            beamEntryStruct *candidate = &step->candidates[ (size_t) entry * BeamWidth + i];
+            *candidate = *parent;
+            strcpy( candidate->words[ parent->length], bestWords[ i].word);
+            candidate->scores[ parent->length] = bestWords[ i].score;
+            candidate->length = parent->length + 1;
+            candidate->total = parent->total + bestWords[ i].score;
+            candidate->parent = entry;
+        }
+        step->candidateCounts[ entry] = bestCount;
+        addToProfileCounter( &Profile.pairsScored, (long) scoredCount * step->answersWordCount);
+    }
+    free( scoredWords);
+    free( bestWords);
+} //end extendBeamEntries(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Work for computing the blanked-letter masks of a new beam from those of the previous beam.
+typedef struct beamMaskStep beamMaskStepStruct;
+struct beamMaskStep{
+    wordCountStruct *answerWords;   // Array of the unchanged answer words
+    int answersWordCount;           // How many words there are in answerWords
+    beamEntryStruct *beam;          // New beam
+    uint8_t *parentMasks;           // Masks of the previous beam
+    uint8_t *blankedMasks;          // Masks of the new beam, to be filled in
+};
+
+
+// -----------------------------------------------------------------------------------------
+// Remove the letters of the newest word of beam entries start..end-1 from their parents' answers.
+void updateBeamMasks( void *stepParameter, int start, int end)
+{
+    beamMaskStepStruct *step = (beamMaskStepStruct *) stepParameter;
+    for( int entry=start; entry<end; entry++) {
+        beamEntryStruct *beamEntry = &step->beam[ entry];
+        uint8_t *parentMasks = &step->parentMasks[ (size_t) beamEntry->parent * step->answersWordCount];
+        uint8_t *masks = &step->blankedMasks[ (size_t) entry * step->answersWordCount];
+        for( int i=0; i<step->answersWordCount; i++) {
+            masks[ i] = removeMatchingLettersFromMask( step->answerWords[ i].word, parentMasks[ i],
+                                                       beamEntry->words[ beamEntry->length - 1]);
+        }
+    }
+} //end updateBeamMasks(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Find good sequences of BeamDepth opening words, generalizing findAndDisplayBestSecondWords(..)
+// to any depth.  Each word is scored against the answers with the letters of the earlier words
+// removed by removeMatchingLetters(..) rules.  Only the BeamWidth best partial sequences are
+// extended at each depth.  Removed letters are kept as one bit mask byte per answer per
+// sequence rather than as copies of the answer words.  Returns how many sequences are in the
+// final beam, best first.
+int findBestSequences(
+        wordCountStruct *answerWords,   // The set of answer words
+        int answersWordCount,           // How many answer words there are
+        wordCountStruct *allWords,      // The set of all words
+        int totalWordCount,             // How many allWords there are
+        beamEntryStruct * *bestSequences) // The final beam, to be allocated
+{
+    wordCountStruct *words = NULL;
+    int wordCount = getDistinctWordsByScore( allWords, totalWordCount, &words);
+    int depth = BeamDepth < MAX_BEAM_DEPTH ? BeamDepth : MAX_BEAM_DEPTH;
+    if( depth > wordCount) {
+        depth = wordCount;
+    }
+
+    // Start from a single empty sequence with nothing blanked out
+    beamEntryStruct *beam = (beamEntryStruct *) countedCalloc( 1, sizeof( beamEntryStruct));
+    uint8_t *blankedMasks = (uint8_t *) countedCalloc( answersWordCount, 1);
+    int beamSize = 1;
+
+    for( int d=0; d<depth; d++) {
+        // Every entry proposes its BeamWidth best extensions, scored in parallel
+        beamEntryStruct *candidates = (beamEntryStruct *) countedMalloc( sizeof( beamEntryStruct) * beamSize * BeamWidth);
+        int *candidateCounts = (int *) countedCalloc( beamSize, sizeof( int));
+        beamStepStruct step = { answerWords, answersWordCount, words, wordCount, beam, blankedMasks,
+                                candidates, candidateCounts};
+        runInParallel( beamSize, 1, extendBeamEntries, &step);
+
+        // Keep the BeamWidth best extensions overall
+        int candidateCount = 0;
+        for( int entry=0; entry<beamSize; entry++) {
+            for( int i=0; i<candidateCounts[ entry]; i++) {
+                candidates[ candidateCount++] = candidates[ (size_t) entry * BeamWidth + i];
+            }
+        }
+        qsort( candidates, candidateCount, sizeof( beamEntryStruct), compareBeamEntries);
+        int newBeamSize = candidateCount < BeamWidth ? candidateCount : BeamWidth;
+
+        // Blank out the letters of each kept sequence's newest word
+        uint8_t *newMasks = (uint8_t *) countedMalloc( (size_t) newBeamSize * answersWordCount + 1);
+        beamMaskStepStruct maskStep = { answerWords, answersWordCount, candidates, blankedMasks, newMasks};
+        runInParallel( newBeamSize, 1, updateBeamMasks, &maskStep);
+
+        free( beam);
+        free( blankedMasks);
+        free( candidateCounts);
+        beam = candidates;
+        blankedMasks = newMasks;
+        beamSize = newBeamSize;
+    }
+    free( blankedMasks);
+    free( words);
+    *bestSequences = beam;
+    return beamSize;
+} //end findBestSequences(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Find and display good sequences of BeamDepth opening words, see findBestSequences(..).
+void findAndDisplayBestSequences(
+        wordCountStruct *answerWords,   // The set of answer words
+        int answersWordCount,           // How many answer words there are
+        wordCountStruct *allWords,      // The set of all words
+        int totalWordCount)             // How many allWords there are
+{
+    beamEntryStruct *beam = NULL;
+    int beamSize = findBestSequences( answerWords, answersWordCount, allWords, totalWordCount, &beam);
+    int depth = beamSize > 0 ? beam[ 0].length : 0;
+
+    if( OutputFormat == FORMAT_JSON) {
+        printf("{\"query\":\"beam\",\"sequences\":[");
+        for( int entry=0; entry<beamSize; entry++) {
+            printf("%s{\"words\":[", entry > 0 ? "," : "");
+            for( int i=0; i<beam[ entry].length; i++) {
+                printf("%s{\"word\":\"%s\",\"score\":%d}", i > 0 ? "," : "", beam[ entry].words[ i], beam[ entry].scores[ i]);
+            }
+            printf("],\"total\":%d}", beam[ entry].total);
+        }
+        printf("]}\n");
+    }
+    else {
+        printf("Best sequences of %d words (beam width %d):\n", depth, BeamWidth);
+        for( int entry=0; entry<beamSize; entry++) {
+            for( int i=0; i<beam[ entry].length; i++) {
+                printf("%s %d   ", beam[ entry].words[ i], beam[ entry].scores[ i]);
+            }
+            printf("total %d\n", beam[ entry].total);
+        }
+    }
+
+    free( beam);
+} //end findAndDisplayBestSequences(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Bit masks over the answer words used to narrow down the possible answers from feedback.
+// A set of answers is a bitset of blockCount 64-bit words, bit i standing for answerWords[ i].
+typedef struct candidateIndex candidateIndexStruct;
+struct candidateIndex{
+    int answersWordCount;       // How many answer words there are
+    int blockCount;             // 64-bit words per bitset
+    uint64_t *positionMasks;    // [ position][ letter]: answers with that letter in that position
+    uint64_t *atLeastMasks;     // [ letter][ k]: answers with at least k copies of the letter
+};
+
+
+// -----------------------------------------------------------------------------------------
+// Return the bitset of answers with the given letter in the given position.
+uint64_t *getPositionMask( candidateIndexStruct *index, int position, int letter)
+{
+    return &index->positionMasks[ ((size_t) position * ALPHABET_SIZE + letter) * index->blockCount];
+} //end getPositionMask(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Return the bitset of answers with at least count copies of the given letter.
+uint64_t *getAtLeastMask( candidateIndexStruct *index, int letter, int count)
+{
+    return &index->atLeastMasks[ ((size_t) letter * (WordLength + 1) + count) * index->blockCount];
+} //end getAtLeastMask(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Build the per-position and per-letter-count bit masks for the answer words.
+void buildCandidateIndex(
+        wordCountStruct *answerWords,   // Array of the answer words
+        int answersWordCount,           // How many words there are in answerWords
+        candidateIndexStruct *index)    // Index to be allocated and filled in
+{
+    index->answersWordCount = answersWordCount;
+    index->blockCount = (answersWordCount + 63) / 64;
+    index->positionMasks = (uint64_t *) countedCalloc( (size_t) WordLength * ALPHABET_SIZE * index->blockCount, sizeof( uint64_t));
+    index->atLeastMasks = (uint64_t *) countedCalloc( (size_t) ALPHABET_SIZE * (WordLength + 1) * index->blockCount, sizeof( uint64_t));
+
+    for( int i=0; i<answersWordCount; i++) {
+        uint64_t bit = 1ULL << (i % 64);
+        int letterCounts[ ALPHABET_SIZE] = { 0};
+        for( int j=0; j<WordLength; j++) {
+            int letter = answerWords[ i].word[ j] - 'a';
+            getPositionMask( index, j, letter)[ i / 64] |= bit;
+            letterCounts[ letter]++;
+        }
+        for( int letter=0; letter<ALPHABET_SIZE; letter++) {
+            for( int k=0; k<=letterCounts[ letter]; k++) {
+                getAtLeastMask( index, letter, k)[ i / 64] |= bit;
+            }
+        }
+    }
+} //end buildCandidateIndex(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Release the masks of a candidate index.
+void freeCandidateIndex( candidateIndexStruct *index)
+{
+    free( index->positionMasks);
+    free( index->atLeastMasks);
+} //end freeCandidateIndex(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Set the bitset to hold every answer.
+void setAllCandidates( candidateIndexStruct *index, uint64_t *candidates)
+{
+    for( int b=0; b<index->blockCount; b++) {
+        candidates[ b] = ~0ULL;
+    }
+    if( index->answersWordCount % 64 != 0) {
+        candidates[ index->blockCount - 1] = (1ULL << (index->answersWordCount % 64)) - 1;
+    }
+} //end setAllCandidates(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Keep in candidates (if mask is true) or remove from candidates (if mask is false) the
+// answers in the given bitset.
+void intersectCandidates( candidateIndexStruct *index, uint64_t *candidates, uint64_t *mask, int isKept)
+{
+    uint64_t flip = isKept ? 0 : ~0ULL;
+    for( int b=0; b<index->blockCount; b++) {
+        candidates[ b] &= mask[ b] ^ flip;
+    }
+} //end intersectCandidates(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Narrow down the candidates to the answers that would give this feedback for this guess.
+// Feedback has one character per letter: 'g' for green, 'y' for yellow and '-', '.', 'x' or
+// 'b' for grey, in either case.  Returns 0 without changing candidates if the guess or the
+// feedback is not valid.
+int applyFeedbackToCandidates(
+        candidateIndexStruct *index,    // Masks of the answer words
+        uint64_t *candidates,           // Bitset of remaining answers, narrowed down in place
+        char guess[],                   // The word that was guessed
+        char feedback[])                // The colors the guess got
+{
+    if( strlen( guess) != (size_t) WordLength || strlen( feedback) != (size_t) WordLength) {
+        return 0;
+    }
+    int colors[ MAX_WORD_LENGTH];   // 2 green, 1 yellow, 0 grey
+    for( int j=0; j<WordLength; j++) {
+        char c = feedback[ j];
+        if( guess[ j] < 'a' || guess[ j] > 'z') {
+            return 0;
+        }
+        if( c == 'g' || c == 'G') {
+            colors[ j] = 2;
+        } else if( c == 'y' || c == 'Y') {
+            colors[ j] = 1;
+        } else if( strchr( "-.xXbB", c) != NULL) {
+            colors[ j] = 0;
+        } else {
+            return 0;
+        }
+    }
+
+    // A green letter must be in its position, any other color means it is not there
+    for( int j=0; j<WordLength; j++) {
+        intersectCandidates( index, candidates, getPositionMask( index, j, guess[ j] - 'a'), colors[ j] == 2);
+    }
+
+    // Each green or yellow copy of a letter means the answer has at least that many copies.
+    // A grey copy as well means it has exactly that many.
+    for( int j=0; j<WordLength; j++) {
+        if( strchr( guess, guess[ j]) != &guess[ j]) {
+            continue;   // Letter already handled at its first position
+        }
+        int shownCount = 0;
+        int hasGrey = 0;
+        for( int k=j; k<WordLength; k++) {
+            if( guess[ k] == guess[ j]) {
+                shownCount += colors[ k] > 0;
+                hasGrey |= colors[ k] == 0;
+            }
+        }
+        intersectCandidates( index, candidates, getAtLeastMask( index, guess[ j] - 'a', shownCount), 1);
+        if( hasGrey && shownCount < WordLength) {
+            intersectCandidates( index, candidates, getAtLeastMask( index, guess[ j] - 'a', shownCount + 1), 0);
+        }
+    }
+    return 1;
+} //end applyFeedbackToCandidates(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Copy the answers in the candidates bitset into the words array.  Returns how many there are.
+int collectCandidates(
+        candidateIndexStruct *index,    // Masks of the answer words
+        uint64_t *candidates,           // Bitset of remaining answers
+        wordCountStruct *answerWords,   // Array of the answer words
+        wordCountStruct *words)         // Array with room for all answers, filled in
+{
+    int count = 0;
+    for( int b=0; b<index->blockCount; b++) {
+        uint64_t bits = candidates[ b];
+        while( bits != 0) {
+            words[ count++] = answerWords[ b * 64 + __builtin_ctzll( bits)];
+            bits &= bits - 1;
+        }
+    }
+    return count;
+} //end collectCandidates(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Interactive solver.  After each guess and its feedback the possible answers are narrowed
+// down, and all words are scored again against only the answers that are still possible.
+void runInteractiveSolver(
+        wordCountStruct *answerWords,   // The set of answer words
+        int answersWordCount,           // How many answer words there are
+        wordCountStruct *allWords,      // The set of all words
+        int totalWordCount)             // How many allWords there are
+{
+    candidateIndexStruct index;
+    buildCandidateIndex( answerWords, answersWordCount, &index);
+    uint64_t *candidates = (uint64_t *) countedMalloc( sizeof( uint64_t) * index.blockCount);
+    uint64_t *previousCandidates = (uint64_t *) countedMalloc( sizeof( uint64_t) * index.blockCount);
+    wordCountStruct *candidateWords = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * answersWordCount);
+    setAllCandidates( &index, candidates);
+
+    printf("Enter each guess and its feedback, using g for green, y for yellow and - for grey,\n");
+    printf("for example: soare -y--g.  Enter quit to stop.\n");
+    while( 1) {
+        int candidateCount = collectCandidates( &index, candidates, answerWords, candidateWords);
+        if( candidateCount == 1) {
+            printf("The answer is %s\n", candidateWords[ 0].word);
+            break;
+        }
+
+        // Score all words against the remaining answers and show the best next guesses
+        int numberOfTopScoringWords = 0;
+        wordCountStruct *bestWords = NULL;
+        findScoresAndTopWords( candidateWords, NULL, candidateCount, allWords, totalWordCount,
+                               &bestWords, &numberOfTopScoringWords);
+        numberOfTopScoringWords = removeRepeatedWords( bestWords, numberOfTopScoringWords);
+        printf("%d possible answers", candidateCount);
+        if( candidateCount <= 20) {
+            printf(":");
+            for( int i=0; i<candidateCount; i++) {
+                printf(" %s", candidateWords[ i].word);
+            }
+        }
+        printf("\nBest next guesses:");
+        for( int i=0; i<numberOfTopScoringWords; i++) {
+            printf(" %s %d", bestWords[ i].word, bestWords[ i].score);
+        }
+        printf("\n");
+        free( bestWords);
+
+        // Read the next guess and feedback
+        char guess[ 81];
+        char feedback[ 81];
+        printf("Guess and feedback: ");
+        if( scanf("%80s", guess) != 1 || strcmp( guess, "quit") == 0 || scanf("%80s", feedback) != 1) {
+            break;
+        }
+        memcpy( previousCandidates, candidates, sizeof( uint64_t) * index.blockCount);
+        if( ! applyFeedbackToCandidates( &index, candidates, guess, feedback)) {
+            printf("Please enter a %d-letter lowercase guess and %d feedback letters\n", WordLength, WordLength);
+        }
+        else if( collectCandidates( &index, candidates, answerWords, candidateWords) == 0) {
+            printf("No answers give that feedback, so it was ignored\n");
+            memcpy( candidates, previousCandidates, sizeof( uint64_t) * index.blockCount);
+        }
+    }
+
+    free( candidates);
+    free( previousCandidates);
+    free( candidateWords);
+    freeCandidateIndex( &index);
+} //end runInteractiveSolver(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Write a list of words and scores in the current OutputFormat: "word score word score ..."
+// for plain output, or a JSON array of {"word":..,"score":..} objects.
+void writeWordList( FILE *out, wordCountStruct *words, int count)
+{
+    if( OutputFormat == FORMAT_JSON) {
+        fprintf( out, "[");
+        for( int i=0; i<count; i++) {
+            fprintf( out, "%s{\"word\":\"%s\",\"score\":%d}", i > 0 ? "," : "", words[ i].word, words[ i].score);
+        }
+        fprintf( out, "]");
+    }
+    else {
+        for( int i=0; i<count; i++) {
+            fprintf( out, "%s%s %d", i > 0 ? " " : "", words[ i].word, words[ i].score);
+        }
+    }
+} //end writeWordList(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Write the response to a "first" query: the best first words.
+void writeFirstWords( FILE *out, wordCountStruct *words, int count)
+{
+    if( OutputFormat == FORMAT_JSON) {
+        fprintf( out, "{\"query\":\"first\",\"words\":");
+        writeWordList( out, words, count);
+        fprintf( out, "}\n");
+    }
+    else {
+        writeWordList( out, words, count);
+        fprintf( out, "\n");
+    }
+} //end writeFirstWords(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Write the response to a "second" query: the first word, then its best second words.
+void writeSecondWords( FILE *out, wordCountStruct *first, wordCountStruct *words, int count)
+{
+    if( OutputFormat == FORMAT_JSON) {
+        fprintf( out, "{\"query\":\"second\",\"first\":{\"word\":\"%s\",\"score\":%d},\"words\":", first->word, first->score);
+        writeWordList( out, words, count);
+        fprintf( out, "}\n");
+    }
+    else {
+        fprintf( out, "%s %d:", first->word, first->score);
+        if( count > 0) {
+            fprintf( out, " ");
+        }
+        writeWordList( out, words, count);
+        fprintf( out, "\n");
+    }
+} //end writeSecondWords(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Write an error response for a query that could not be answered.
+void writeQueryError( FILE *out, char message[])
+{
+    if( OutputFormat == FORMAT_JSON) {
+        fprintf( out, "{\"error\":\"%s\"}\n", message);
+    }
+    else {
+        fprintf( out, "error: %s\n", message);
+    }
+} //end writeQueryError(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Everything loaded and indexed once so that many queries can be answered quickly.
+typedef struct queryServer queryServerStruct;
+struct queryServer{
+    wordCountStruct *answerWords;   // The set of answer words
+    int answersWordCount;           // How many answer words there are
+    wordCountStruct *allWords;      // The set of all words, scores are overwritten by queries
+    int totalWordCount;             // How many allWords there are
+    wordCountStruct *rankedWords;   // All words scored as first words, best first, each word once
+    int rankedWordCount;            // How many different words there are in rankedWords
+    wordCountStruct *answerWordsCopy; // Space for answers with letters removed or filtered
+    candidateIndexStruct index;     // Masks for narrowing down answers from feedback
+    uint64_t *candidates;           // Bitset of answers, reused by filter queries
+};
+
+
+// -----------------------------------------------------------------------------------------
+// Load nothing, but score and index the already loaded words for answering queries.
+void prepareQueryServer(
+        queryServerStruct *server,      // Server to be set up
+        wordCountStruct *answerWords,   // The set of answer words
+        int answersWordCount,           // How many answer words there are
+        wordCountStruct *allWords,      // The set of all words
+        int totalWordCount)             // How many allWords there are
+{
+    server->answerWords = answerWords;
+    server->answersWordCount = answersWordCount;
+    server->allWords = allWords;
+    server->totalWordCount = totalWordCount;
+
+    // Rank every word as a first word once, so first word queries are just a lookup
+    struct timespec phaseStart;
+    startProfilePhase( &phaseStart);
+    scoreAllWords( answerWords, NULL, answersWordCount, allWords, totalWordCount);
+    endProfilePhase( "first-word pass: scoring", &phaseStart);
+    startProfilePhase( &phaseStart);
+    server->rankedWords = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * totalWordCount);
+    memcpy( server->rankedWords, allWords, sizeof( wordCountStruct) * totalWordCount);
+    qsort( server->rankedWords, totalWordCount, sizeof( wordCountStruct), compareFunction);
+    server->rankedWordCount = removeRepeatedWords( server->rankedWords, totalWordCount);
+    endProfilePhase( "first-word pass: ranking", &phaseStart);
+
+    startProfilePhase( &phaseStart);
+    server->answerWordsCopy = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * answersWordCount);
+    buildCandidateIndex( answerWords, answersWordCount, &server->index);
+    server->candidates = (uint64_t *) countedMalloc( sizeof( uint64_t) * server->index.blockCount);
+    endProfilePhase( "candidate index", &phaseStart);
+} //end prepareQueryServer(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Answer "first [N]": the N best first words, or those tied for best if N is not given.
+void answerFirstQuery( queryServerStruct *server, int count, FILE *out)
+{
+    if( count <= 0) {
+        count = 0;
+        while( count < server->rankedWordCount && server->rankedWords[ count].score == server->rankedWords[ 0].score) {
+            count++;
+        }
+    }
+    if( count > server->rankedWordCount) {
+        count = server->rankedWordCount;
+    }
+    writeFirstWords( out, server->rankedWords, count);
+} //end answerFirstQuery(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Answer "second WORD [N]": the best second words once WORD's letters are removed.
+void answerSecondQuery( queryServerStruct *server, char firstWord[], int count, FILE *out)
+{
+    // The first word does not need to be in the word lists, so score it on its own
+    wordCountStruct first;
+    memset( &first, 0, sizeof( first));
+    strcpy( first.word, firstWord);
+    scoreAllWords( server->answerWords, NULL, server->answersWordCount, &first, 1);
+
+    int savedTopWordsCount = TopWordsCount;
+    TopWordsCount = count;
+    int numberOfTopScoringSecondWords = 0;
+    wordCountStruct *bestSecondWords = NULL;
+    findBestSecondWords( server->answerWords, server->answersWordCount, server->allWords, server->totalWordCount,
+                         firstWord, server->answerWordsCopy, &bestSecondWords, &numberOfTopScoringSecondWords);
+    TopWordsCount = savedTopWordsCount;
+
+    writeSecondWords( out, &first, bestSecondWords, numberOfTopScoringSecondWords);
+    free( bestSecondWords);
+} //end answerSecondQuery(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Answer "filter GUESS FEEDBACK [GUESS FEEDBACK ...]": the answers still possible after the
+// given feedback, and the best next guesses against them.
+void answerFilterQuery( queryServerStruct *server, char *guesses[], char *feedbacks[], int feedbackCount,
+                        int count, FILE *out)
+{
+    setAllCandidates( &server->index, server->candidates);
+    for( int i=0; i<feedbackCount; i++) {
+        if( ! applyFeedbackToCandidates( &server->index, server->candidates, guesses[ i], feedbacks[ i])) {
+            writeQueryError( out, "guesses must be lowercase words and feedback g, y or - per letter");
+            return;
+        }
+    }
+    int candidateCount = collectCandidates( &server->index, server->candidates, server->answerWords, server->answerWordsCopy);
+
+    // Best next guesses against the remaining answers
+    int numberOfTopScoringWords = 0;
+    wordCountStruct *bestWords = NULL;
+    if( candidateCount > 0) {
+        int savedTopWordsCount = TopWordsCount;
+        TopWordsCount = count;
+        findScoresAndTopWords( server->answerWordsCopy, NULL, candidateCount, server->allWords, server->totalWordCount,
+                               &bestWords, &numberOfTopScoringWords);
+        numberOfTopScoringWords = removeRepeatedWords( bestWords, numberOfTopScoringWords);
+        TopWordsCount = savedTopWordsCount;
+    }
+
+    if( OutputFormat == FORMAT_JSON) {
+        fprintf( out, "{\"query\":\"filter\",\"count\":%d,\"candidates\":[", candidateCount);
+        for( int i=0; i<candidateCount; i++) {
+            fprintf( out, "%s\"%s\"", i > 0 ? "," : "", server->answerWordsCopy[ i].word);
+        }
+        fprintf( out, "],\"words\":");
+        writeWordList( out, bestWords, numberOfTopScoringWords);
+        fprintf( out, "}\n");
+    }
+    else {
+        fprintf( out, "%d:", candidateCount);
+        for( int i=0; i<candidateCount; i++) {
+            fprintf( out, " %s", server->answerWordsCopy[ i].word);
+        }
+        fprintf( out, " |%s", numberOfTopScoringWords > 0 ? " " : "");
+        writeWordList( out, bestWords, numberOfTopScoringWords);
+        fprintf( out, "\n");
+    }
+    free( bestWords);
+} //end answerFilterQuery(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Answer one query line.  Returns 0 when the line asks to end the session ("quit"), or -1
+// when it asks to stop the server ("shutdown"), and 1 otherwise.
+int answerQuery( queryServerStruct *server, char line[], FILE *out)
+{
+    char *tokens[ 64];
+    int tokenCount = 0;
+    for( char *token = strtok( line, " \t\r\n"); token != NULL && tokenCount < 64; token = strtok( NULL, " \t\r\n")) {
+        tokens[ tokenCount++] = token;
+    }
+    if( tokenCount == 0) {
+        return 1;   // Ignore empty lines
+    }
+
+    if( strcmp( tokens[ 0], "quit") == 0) {
+        return 0;
+    }
+    else if( strcmp( tokens[ 0], "shutdown") == 0) {
+        return -1;
+    }
+    else if( strcmp( tokens[ 0], "first") == 0 && tokenCount <= 2) {
+        answerFirstQuery( server, tokenCount == 2 ? atoi( tokens[ 1]) : TopWordsCount, out);
+    }
+    else if( strcmp( tokens[ 0], "second") == 0 && (tokenCount == 2 || tokenCount == 3)) {
+        int isValid = strlen( tokens[ 1]) == (size_t) WordLength;
+        for( int j=0; isValid && j<WordLength; j++) {
+            isValid = tokens[ 1][ j] >= 'a' && tokens[ 1][ j] <= 'z';
+        }
+        if( isValid) {
+            answerSecondQuery( server, tokens[ 1], tokenCount == 3 ? atoi( tokens[ 2]) : TopWordsCount, out);
+        }
+        else {
+            writeQueryError( out, "second needs a lowercase word");
+        }
+    }
+    else if( strcmp( tokens[ 0], "filter") == 0 && tokenCount % 2 == 1) {
+        // Pairs of guess and feedback
+        char *guesses[ 32];
+        char *feedbacks[ 32];
+        int feedbackCount = 0;
+        for( int i=1; i+1<tokenCount; i+=2) {
+            guesses[ feedbackCount] = tokens[ i];
+            feedbacks[ feedbackCount++] = tokens[ i+1];
+        }
+        answerFilterQuery( server, guesses, feedbacks, feedbackCount, TopWordsCount, out);
+    }
+    else {
+        writeQueryError( out, "expected first [N], second WORD [N], filter [GUESS FEEDBACK ...] or quit");
+    }
+    fflush( out);
+    return 1;
+} //end answerQuery(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Answer query lines from in until it ends or asks to quit.  Returns -1 on "shutdown".
+int serveQueries( queryServerStruct *server, FILE *in, FILE *out)
+{
+    char line[ 4096];
+    while( fgets( line, sizeof( line), in) != NULL) {
+        int result = answerQuery( server, line, out);
+        if( result <= 0) {
+            return result;
+        }
+        if( ferror( out)) {
+            return 0;   // The client has gone (EPIPE), so stop answering it
+        }
+    }
+    return 0;
+} //end serveQueries(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Long-running server: index the words once, then answer queries on stdin and stdout, or on
+// a local Unix socket if socketPath is not NULL.  Socket connections are handled one at a
+// time, since queries reuse the score space in allWords.
+void runQueryServer(
+        char *socketPath,               // Unix socket to listen on, or NULL for stdin/stdout
+        wordCountStruct *answerWords,   // The set of answer words
+        int answersWordCount,           // How many answer words there are
+        wordCountStruct *allWords,      // The set of all words
+        int totalWordCount)             // How many allWords there are
+{
+    queryServerStruct server;
+    prepareQueryServer( &server, answerWords, answersWordCount, allWords, totalWordCount);
+    if( socketPath == NULL) {
+        serveQueries( &server, stdin, stdout);
+        return;
+    }
+
+    struct sockaddr_un address;
+    memset( &address, 0, sizeof( address));
+    address.sun_family = AF_UNIX;
+    if( strlen( socketPath) >= sizeof( address.sun_path)) {
+        printf("Error: socket path %s is too long\n", socketPath);
+        exit(-1);
+    }
+    strcpy( address.sun_path, socketPath);
+    int serverSocket = socket( AF_UNIX, SOCK_STREAM, 0);
+    unlink( socketPath);   // Remove a socket left behind by an earlier run
+    if( serverSocket < 0 || bind( serverSocket, (struct sockaddr *) &address, sizeof( address)) != 0
+        || listen( serverSocket, 16) != 0) {
+        printf("Error: could not listen on %s\n", socketPath);
+        exit(-1);
+    }
+
+    // A client closing its connection before its reply is written must not end the server,
+    // so writes to it fail with EPIPE instead of raising SIGPIPE
+    signal( SIGPIPE, SIG_IGN);
+    int result = 0;
+    while( result >= 0) {
+        int client = accept( serverSocket, NULL, NULL);
+        if( client < 0 && (errno == EINTR || errno == ECONNABORTED)) {
+            continue;
+        }
+        if( client < 0) {
+            printf("Error: could not accept connections on %s: %s\n", socketPath, strerror( errno));
+            close( serverSocket);
+            unlink( socketPath);
+            exit(-1);
+        }
+        FILE *in = fdopen( client, "r");
+        if( in == NULL) {
+            close( client);
+            continue;
+        }
+        int outDescriptor = dup( client);
+        FILE *out = outDescriptor < 0 ? NULL : fdopen( outDescriptor, "w");
+        if( out == NULL) {
+            if( outDescriptor >= 0) {
+                close( outDescriptor);
+            }
+            fclose( in);
+            continue;
+        }
+        result = serveQueries( &server, in, out);
+        fclose( in);
+        fclose( out);
+    }
+    close( serverSocket);
+    unlink( socketPath);
+} //end runQueryServer(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Non-interactive run of one mode, writing results in OutputFormat to stdout.
+void runBatchMode(
+        char mode[],                    // first, second, pairs, beam or filter
+        char *guesses[],                // Guesses for filter mode
+        char *feedbacks[],              // Feedback for each guess, for filter mode
+        int feedbackCount,              // How many guesses and feedbacks there are
+        wordCountStruct *answerWords,   // The set of answer words
+        int answersWordCount,           // How many answer words there are
+        wordCountStruct *allWords,      // The set of all words
+        int totalWordCount)             // How many allWords there are
+{
+    struct timespec phaseStart;
+    startProfilePhase( &phaseStart);
+    if( strcmp( mode, "pairs") == 0) {
+        findAndDisplayBestPairs( answerWords, answersWordCount, allWords, totalWordCount);
+        endProfilePhase( "pair search", &phaseStart);
+        return;
+    }
+    if( strcmp( mode, "beam") == 0) {
+        findAndDisplayBestSequences( answerWords, answersWordCount, allWords, totalWordCount);
+        endProfilePhase( "beam search", &phaseStart);
+        return;
+    }
+
+    queryServerStruct server;
+    prepareQueryServer( &server, answerWords, answersWordCount, allWords, totalWordCount);
+    if( strcmp( mode, "first") == 0) {
+        answerFirstQuery( &server, TopWordsCount, stdout);
+    }
+    else if( strcmp( mode, "second") == 0) {
+        // Best second words for each of the best first words, like menu option 2
+        int count = TopWordsCount;
+        if( count <= 0) {
+            count = 0;
+            while( count < server.rankedWordCount && server.rankedWords[ count].score == server.rankedWords[ 0].score) {
+                count++;
+            }
+        }
+        for( int i=0; i<count && i<server.rankedWordCount; i++) {
+            answerSecondQuery( &server, server.rankedWords[ i].word, TopWordsCount, stdout);
+        }
+    }
+    else if( strcmp( mode, "filter") == 0) {
+        answerFilterQuery( &server, guesses, feedbacks, feedbackCount, TopWordsCount, stdout);
+    }
+} //end runBatchMode(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Block of memory allocated once and handed out in pieces, so the buffers of the streaming
+// passes fit within --mem-cap and are reused by every pass instead of allocated for each one.
+typedef struct scratchArena scratchArenaStruct;
+struct scratchArena{
+    char *memory;           // The block
+    size_t size;            // Bytes in the block
+    size_t used;            // Bytes handed out so far
+};
+#define ARENA_ALIGNMENT 64  // Pieces start on their own cache line
+
+
+//-----------------------------------------------------------------------------------------
+// Allocate an arena with room for size bytes of pieces.
+void createScratchArena( scratchArenaStruct *arena, size_t size)
+{
+    arena->memory = (char *) countedMalloc( size + ARENA_ALIGNMENT);
+    arena->size = size + ARENA_ALIGNMENT;
+    arena->used = ARENA_ALIGNMENT - (uintptr_t) arena->memory % ARENA_ALIGNMENT;
+} //end createScratchArena(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Hand out the next size bytes of the arena.  The arena is sized for everything handed out,
+// so running out is a bug rather than a lack of memory.
+void *allocateFromArena( scratchArenaStruct *arena, size_t size)
+{
+    size = (size + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT;
+    if( arena->used + size > arena->size) {
+        printf("Error: scratch arena of %zu bytes is full\n", arena->size);
+        exit(-1);
+    }
+    void *piece = arena->memory + arena->used;
+    arena->used += size;
+    return piece;
+} //end allocateFromArena(..)
+
+
+// -----------------------------------------------------------------------------------------
+// With --mem-cap the guesses are streamed rather than read into memory.  Only the answers
+// are kept in memory, and the words of allWords, the answers followed by the guesses file,
+// are read and scored a tile of tileSize words at a time.  The tile is sized so that it and
+// the buffers for the answers fit within the cap.  Within a tile the threads still claim
+// SCORING_CHUNK_SIZE words at a time, small enough to stay in cache.
+typedef struct wordStream wordStreamStruct;
+struct wordStream{
+    wordCountStruct *answerWords;   // The answer words, kept in memory
+    int answersWordCount;           // How many answer words there are
+    wordFileStruct guessesFile;     // Mapped guesses file, read a tile at a time
+    int guessesWordCount;           // How many words there are in the guesses file
+    int tileSize;                   // Most words read and scored at once
+    wordCountStruct *tile;          // Room for tileSize words
+    wordCountStruct *mergedWords;   // Room for twice TopWordsCount words, to merge a tile's best words
+    wordCountStruct *answerWordsCopy; // Room for the answers with a first word's letters removed
+    wordCountStruct *uniqueAnswers; // Room for the different answers among those
+    int *answerWeights;             // Room for the weights of the different answers
+    scratchArenaStruct arena;       // The buffers above are allocated from this
+};
+
+// Bytes needed for each word of a tile: the word, its first copy index and the slots of the
+// table finding repeats, see getFirstCopies(..) and selectTopWords(..), and the part of the
+// mapped file holding it
+#define STREAM_BYTES_PER_WORD (sizeof( wordCountStruct) + sizeof( int) \
+                               + 4 * (sizeof( uint64_t) + sizeof( int)) + MAX_WORD_LENGTH + 2)
+
+
+//-----------------------------------------------------------------------------------------
+// Bytes used while streaming that do not depend on the tile size: the answers and the arena
+// buffers for them, the packed answers, the table grouping identical answers, the best words
+// and each thread's histograms for the pattern engines.  Words tied for best are not counted,
+// as there are normally only a few.
+long getStreamAnswerBytes( int answersWordCount)
+{
+    long paddedCount = (answersWordCount + PACKED_BLOCK_SIZE - 1) / PACKED_BLOCK_SIZE * PACKED_BLOCK_SIZE;
+    long bytes = (long) (3 * sizeof( wordCountStruct) + sizeof( int)) * answersWordCount
+                 + (paddedCount + 1) * (WordLength + ALPHABET_SIZE + 1)
+                 + (4L * answersWordCount + 16) * (sizeof( uint64_t) + sizeof( int))
+                 + 3L * sizeof( wordCountStruct) * (TopWordsCount > 0 ? TopWordsCount : 0)
+                 + 8L * ARENA_ALIGNMENT;
+    if( ScoringEngine == ENGINE_ENTROPY || ScoringEngine == ENGINE_ELIMINATED) {
+        bytes += (long) getScoringThreadCount() * (sizeof( uint32_t) * PATTERN_GUESS_TILE * Kernels->patternCount
+                                                   + sizeof( uint16_t) * PATTERN_ANSWER_TILE);
+    }
+    return bytes;
+} //end getStreamAnswerBytes(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Read the next tile of words into the stream's tile, continuing after the first
+// wordsStreamed words.  The answers come first, as in allWords, then the guesses file, whose
+// pages are given back once read.  Returns how many words were read, 0 at the end.
+int readNextTile( wordStreamStruct *stream, int wordsStreamed)
+{
+    int count = 0;
+    if( wordsStreamed < stream->answersWordCount) {
+        count = stream->answersWordCount - wordsStreamed;
+        if( count > stream->tileSize) {
+            count = stream->tileSize;
+        }
+        memcpy( stream->tile, &stream->answerWords[ wordsStreamed], sizeof( wordCountStruct) * count);
+    }
+    if( count < stream->tileSize) {
+        count += appendWordsFromFileToArray( &stream->guessesFile, stream->tile, count, stream->tileSize - count);
+        releaseReadPartOfWordFile( &stream->guessesFile);
+    }
+    for( int i=0; i<count; i++) {
+        stream->tile[ i].score = 0;
+        stream->tile[ i].wordIndex = wordsStreamed + i;
+    }
+    return count;
+} //end readNextTile(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Read in the answers, map the guesses file and size the tiles to fit within memoryCap,
+// displaying how many words there are in each file.  The guesses are read once here to
+// count and check them.  Exits with an error if the cap is too small for the answers.
+void openWordStream(
+        wordStreamStruct *stream,       // Stream to be set up
+        char answersFileName[],         // Name of the answers file
+        char guessesFileName[],         // Name of the guesses file
+        long memoryCap)                 // Most bytes the words and buffers may use
+{
+    struct timespec phaseStart;
+    startProfilePhase( &phaseStart);
+    wordFileStruct answersFile;
+    mapWordFile( answersFileName, &answersFile);
+    stream->answerWords = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * getMaximumWordCount( &answersFile));
+    WordLength = 0;
+    stream->answersWordCount = appendWordsFromFileToArray( &answersFile, stream->answerWords, 0, INT_MAX);
+    unmapWordFile( &answersFile);
+    if( stream->answersWordCount == 0) {
+        printf("Error: %s has no words\n", answersFileName);
+        exit(-1);
+    }
+    selectWordLengthKernels( WordLength);
+    stream->answerWords = (wordCountStruct *) countedRealloc( stream->answerWords,
+                                                              sizeof( wordCountStruct) * stream->answersWordCount);
+    mapWordFile( guessesFileName, &stream->guessesFile);
+    endProfilePhase( "loading words", &phaseStart);
+
+    // Whatever the answers leave of the cap goes to the tile, which never needs to be bigger
+    // than all the words
+    long answerBytes = getStreamAnswerBytes( stream->answersWordCount);
+    long tileSize = (memoryCap - answerBytes) / (long) STREAM_BYTES_PER_WORD;
+    long maximumWordCount = (long) stream->answersWordCount + getMaximumWordCount( &stream->guessesFile);
+    if( tileSize > maximumWordCount) {
+        tileSize = maximumWordCount;
+    }
+    if( tileSize < SCORING_CHUNK_SIZE && tileSize < maximumWordCount) {
+        printf("Error: --mem-cap %ld is too small for %d answers, it needs to be at least %ld\n", memoryCap,
+               stream->answersWordCount, answerBytes + SCORING_CHUNK_SIZE * (long) STREAM_BYTES_PER_WORD);
+        exit(-1);
+    }
+    stream->tileSize = (int) tileSize;
+
+    // All the buffers reused from pass to pass come from one arena
+    int answersWordCount = stream->answersWordCount;
+    int mergedCount = TopWordsCount > 0 ? 2 * TopWordsCount : 1;
+    size_t arenaSize = sizeof( wordCountStruct) * ((size_t) stream->tileSize + mergedCount + 2 * answersWordCount)
+                       + sizeof( int) * answersWordCount + 5 * ARENA_ALIGNMENT;
+    createScratchArena( &stream->arena, arenaSize);
+    stream->tile = (wordCountStruct *) allocateFromArena( &stream->arena, sizeof( wordCountStruct) * stream->tileSize);
+    stream->mergedWords = (wordCountStruct *) allocateFromArena( &stream->arena, sizeof( wordCountStruct) * mergedCount);
+    stream->answerWordsCopy = (wordCountStruct *) allocateFromArena( &stream->arena,
+                                                                     sizeof( wordCountStruct) * answersWordCount);
+    stream->uniqueAnswers = (wordCountStruct *) allocateFromArena( &stream->arena,
+                                                                   sizeof( wordCountStruct) * answersWordCount);
+    stream->answerWeights = (int *) allocateFromArena( &stream->arena, sizeof( int) * answersWordCount);
+
+    // Count and check the guesses before spending any time scoring them
+    startProfilePhase( &phaseStart);
+    stream->guessesWordCount = 0;
+    int count = 0;
+    do {
+        count = appendWordsFromFileToArray( &stream->guessesFile, stream->tile, 0, stream->tileSize);
+        releaseReadPartOfWordFile( &stream->guessesFile);
+        stream->guessesWordCount += count;
+    } while( count > 0);
+    endProfilePhase( "counting words", &phaseStart);
+    if( ! IsBatchMode) {
+        printf("%s has %d words\n", answersFileName, stream->answersWordCount);    // Display word counts
+        printf("%s has %d words\n", guessesFileName, stream->guessesWordCount);
+        printf("Streaming %d words at a time within %ld bytes\n", stream->tileSize, memoryCap);
+    }
+} //end openWordStream(..)
+
+
+//-----------------------------------------------------------------------------------------
+// Release everything held by a stream.
+void closeWordStream( wordStreamStruct *stream)
+{
+    unmapWordFile( &stream->guessesFile);
+    free( stream->arena.memory);
+    free( stream->answerWords);
+} //end closeWordStream(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Same as findScoresAndTopWords(..), but streaming the words a tile at a time.  Each tile's
+// best words are merged into the best words so far, so the best words come out the same as
+// if all the words had been scored at once.
+void findScoresAndTopWordsStreaming(
+        wordStreamStruct *stream,       // Stream of all the words
+        wordCountStruct *answerWords,   // Array of the answer words
+        int *answerWeights,             // Weight of each answer, or NULL for one each
+        int answersWordCount,           // How many words there are in answerWords
+        wordCountStruct * *bestWords,   // Array to be allocated to store best words
+        int *numberOfTopScoringWords)   // How many best words were stored
+{
+    char phaseName[ 128];
+    struct timespec phaseStart;
+    startProfilePhase( &phaseStart);
+    preparedAnswersStruct prepared;
+    prepareAnswers( &prepared, answerWords, answerWeights, answersWordCount);
+    rewindWordFile( &stream->guessesFile);
+    int capacity = TopWordsCount > 0 ? TopWordsCount : 16;
+    *bestWords = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * capacity);
+    int count = 0;
+    snprintf( phaseName, sizeof( phaseName), "%s: scoring", ProfilePassName);
+    endProfilePhase( phaseName, &phaseStart);
+
+    int wordsStreamed = 0;
+    while( 1) {
+        startProfilePhase( &phaseStart);
+        int tileCount = readNextTile( stream, wordsStreamed);
+        snprintf( phaseName, sizeof( phaseName), "%s: reading words", ProfilePassName);
+        endProfilePhase( phaseName, &phaseStart);
+        if( tileCount == 0) {
+            break;
+        }
+        wordsStreamed += tileCount;
+
+        startProfilePhase( &phaseStart);
+        int tileTopScore = scoreWordsAgainstAnswers( &prepared, stream->tile, tileCount);
+        snprintf( phaseName, sizeof( phaseName), "%s: scoring", ProfilePassName);
+        endProfilePhase( phaseName, &phaseStart);
+
+        startProfilePhase( &phaseStart);
+        if( TopWordsCount > 0) {
+            // The N best words overall are among the N best so far and this tile's N best
+            memcpy( stream->mergedWords, *bestWords, sizeof( wordCountStruct) * count);
+            count += selectTopWords( stream->tile, tileCount, TopWordsCount, &stream->mergedWords[ count]);
+            count = selectTopWords( stream->mergedWords, count, TopWordsCount, *bestWords);
+        }
+        else {
+            // Keep the words sharing the best score so far, starting over when a tile beats it
+            if( count > 0 && tileTopScore > (*bestWords)[ 0].score) {
+                count = 0;
+            }
+            for( int i=0; i<tileCount && (count == 0 || tileTopScore == (*bestWords)[ 0].score); i++) {
+                if( stream->tile[ i].score != tileTopScore) {
+                    continue;
+                }
+                if( count == capacity) {
+                    capacity *= 2;
+                    *bestWords = (wordCountStruct *) countedRealloc( *bestWords, sizeof( wordCountStruct) * capacity);
+                }
+                (*bestWords)[ count++] = stream->tile[ i];
+            }
+        }
+        snprintf( phaseName, sizeof( phaseName), "%s: top word selection", ProfilePassName);
+        endProfilePhase( phaseName, &phaseStart);
+    }
+    if( TopWordsCount <= 0) {
+        qsort( *bestWords, count, sizeof( wordCountStruct), compareFunction);
+    }
+    *numberOfTopScoringWords = count;
+    freePreparedAnswers( &prepared);
+} //end findScoresAndTopWordsStreaming(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Same as findBestSecondWords(..), but streaming the words, with the residual answers kept
+// in the stream's buffers.
+void findBestSecondWordsStreaming(
+        wordStreamStruct *stream,       // Stream of all the words
+        char bestWord[],                // The first word
+        wordCountStruct * *bestSecondWords, // Array to be allocated to store best second words
+        int *numberOfTopScoringSecondWords) // How many best second words were stored
+{
+    char savedPassName[ sizeof( ProfilePassName)];
+    strcpy( savedPassName, ProfilePassName);
+    snprintf( ProfilePassName, sizeof( ProfilePassName), "second-word pass after %s", bestWord);
+    struct timespec phaseStart;
+    startProfilePhase( &phaseStart);
+    int uniqueCount = getResidualAnswers( stream->answerWords, stream->answersWordCount, bestWord,
+                                          stream->answerWordsCopy, stream->uniqueAnswers, stream->answerWeights);
+    char phaseName[ 128];
+    snprintf( phaseName, sizeof( phaseName), "%s: residual answers", ProfilePassName);
+    endProfilePhase( phaseName, &phaseStart);
+
+    findScoresAndTopWordsStreaming( stream, stream->uniqueAnswers, stream->answerWeights, uniqueCount,
+                                    bestSecondWords, numberOfTopScoringSecondWords);
+    strcpy( ProfilePassName, savedPassName);
+} //end findBestSecondWordsStreaming(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Find and display the best first words, and optionally the best second words for each of
+// them, streaming the words within MemoryCap bytes.  Used for menu options 1 and 2 and for
+// --mode first and second when --mem-cap is given.
+void runStreamingMode(
+        char answersFileName[],         // Name of the answers file
+        char guessesFileName[],         // Name of the guesses file
+        int isSecondWords)              // Set to also find the best second words
+{
+    wordStreamStruct stream;
+    openWordStream( &stream, answersFileName, guessesFileName, MemoryCap);
+
+    int numberOfTopScoringWords = 0;
+    wordCountStruct *bestWords = NULL;  // Will be allocated in function below
+    findScoresAndTopWordsStreaming( &stream, stream.answerWords, NULL, stream.answersWordCount,
+                                    &bestWords, &numberOfTopScoringWords);
+
+    if( ! isSecondWords && IsBatchMode) {
+        writeFirstWords( stdout, bestWords, numberOfTopScoringWords);
+    }
+    else if( ! isSecondWords) {
+        // Display best first-guess words.  There could be multiples if there was a tie.
+        printf("\n");
+        printf("Words and scores for top first words:\n");
+        for (int i = 0; i < numberOfTopScoringWords; i++) {
+            printf("%s %d\n", bestWords[i].word, bestWords[i].score);   // Display
+        }
+    }
+    else {
+        // For each top-scoring word, find the best second word.
+        if( ! IsBatchMode) {
+            printf("\n");
+            printf("Words and scores for top first words and second words:\n");
+        }
+        for( int i=0; i<numberOfTopScoringWords; i++) {
+            int numberOfTopScoringSecondWords = 0;
+            wordCountStruct *bestSecondWords = NULL;  // Will be allocated in function below
+            findBestSecondWordsStreaming( &stream, bestWords[ i].word, &bestSecondWords, &numberOfTopScoringSecondWords);
+            if( IsBatchMode) {
+                writeSecondWords( stdout, &bestWords[ i], bestSecondWords, numberOfTopScoringSecondWords);
+            }
+            else {
+                displayBestSecondWords( bestWords[ i].word, bestWords[ i].score, bestSecondWords,
+                                        numberOfTopScoringSecondWords);
+            }
+            free( bestSecondWords);
+        }
+    }
+    free( bestWords);
+    closeWordStream( &stream);
+} //end runStreamingMode(..)
+
+
+// -----------------------------------------------------------------------------------------
+// A set of answer and guess words used for verifying and benchmarking the scoring code.
+typedef struct benchmarkDataset benchmarkDatasetStruct;
+struct benchmarkDataset{
+    char name[ 32];                 // Shown in the results
+    wordCountStruct *answerWords;   // The set of answer words
+    int answersWordCount;           // How many answer words there are
+    wordCountStruct *allWords;      // The answers followed by the guesses
+    int totalWordCount;             // How many allWords there are
+};
+
+#define BENCHMARK_MAX_PACKED_PAIRS 4000000000L   // Skip full packed passes bigger than this
+#define BENCHMARK_MAX_REFERENCE_PAIRS 40000000L  // Skip full reference passes bigger than this
+
+
+// -----------------------------------------------------------------------------------------
+// Make up count words, taking each letter from the same position of a randomly chosen
+// source word, so the letter frequencies per position match the source words.
+void generateSyntheticWords(
+        wordCountStruct *sourceWords,   // Words to take letters from
+        int sourceCount,                // How many source words there are
+        wordCountStruct *words,         // Array to fill in
+        int count,                      // How many words to make up
+        uint32_t *seed)                 // Random number state, updated
+{
+    for( int i=0; i<count; i++) {
+        for( int j=0; j<WordLength; j++) {
+            // xorshift32 random number generator
+            *seed ^= *seed << 13;
+            *seed ^= *seed >> 17;
+            *seed ^= *seed << 5;
+            words[ i].word[ j] = sourceWords[ *seed % sourceCount].word[ j];
+        }
+        words[ i].word[ WordLength] = '\0';
+        words[ i].score = 0;
+        words[ i].wordIndex = i;
+    }
+} //end generateSyntheticWords(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Load the given files into a dataset, or scale an existing dataset up by making up new
+// answers and guesses with the same letter frequencies when scale is above 1.
+void makeBenchmarkDataset(
+        benchmarkDatasetStruct *dataset,    // Dataset to fill in
+        char name[],                        // Name shown in the results
+        char answersFileName[],             // Answers file, used when source is NULL
+        char guessesFileName[],             // Guesses file, used when source is NULL
+        benchmarkDatasetStruct *source,     // Dataset to scale up, or NULL
+        int scale)                          // How many times bigger than source to make it
+{
+    snprintf( dataset->name, sizeof( dataset->name), "%s", name);
+    if( source == NULL) {
+        readInWordsAndDisplayNumbers( answersFileName, guessesFileName, &dataset->answerWords,
+                                      &dataset->answersWordCount, &dataset->allWords, &dataset->totalWordCount);
+        return;
+    }
+
+    uint32_t seed = 12345 + scale;
+    int guessesCount = (source->totalWordCount - source->answersWordCount) * scale;
+    dataset->answersWordCount = source->answersWordCount * scale;
+    dataset->totalWordCount = dataset->answersWordCount + guessesCount;
+    dataset->allWords = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * dataset->totalWordCount);
+    generateSyntheticWords( source->answerWords, source->answersWordCount, dataset->allWords,
+                            dataset->answersWordCount, &seed);
+    generateSyntheticWords( &source->allWords[ source->answersWordCount], source->totalWordCount - source->answersWordCount,
+                            &dataset->allWords[ dataset->answersWordCount], guessesCount, &seed);
+    for( int i=0; i<dataset->totalWordCount; i++) {
+        dataset->allWords[ i].wordIndex = i;
+    }
+    dataset->answerWords = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * dataset->answersWordCount);
+    memcpy( dataset->answerWords, dataset->allWords, sizeof( wordCountStruct) * dataset->answersWordCount);
+} //end makeBenchmarkDataset(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Release the arrays of a dataset.
+void freeBenchmarkDataset( benchmarkDatasetStruct *dataset)
+{
+    free( dataset->answerWords);
+    free( dataset->allWords);
+} //end freeBenchmarkDataset(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Display one benchmark result line.
+void displayBenchmarkResult( benchmarkDatasetStruct *dataset, char benchmark[], double seconds, double comparisons)
+{
+    printf("%-12s %-34s %10.3f ms %9.3f ns/comparison %12.0f pairs/sec\n", dataset->name, benchmark,
+           seconds * 1e3, seconds * 1e9 / comparisons, comparisons / seconds);
+} //end displayBenchmarkResult(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Check that two arrays of scored words have the same scores.  Displays the result and
+// returns 1 if they match.
+int checkScoresMatch( benchmarkDatasetStruct *dataset, char path[], wordCountStruct *expected,
+                      wordCountStruct *actual, int count)
+{
+    for( int i=0; i<count; i++) {
+        if( expected[ i].score != actual[ i].score || strcmp( expected[ i].word, actual[ i].word) != 0) {
+            printf("verify %-12s %-34s MISMATCH at %s: %d instead of %d\n", dataset->name, path,
+                   expected[ i].word, actual[ i].score, expected[ i].score);
+            return 0;
+        }
+    }
+    printf("verify %-12s %-34s ok\n", dataset->name, path);
+    return 1;
+} //end checkScoresMatch(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Feedback pattern of a guess against one answer, worked out letter by letter the way the
+// game does it, for checking the pattern kernels.  Green is 2, yellow 1 and grey 0, with the
+// first letter as the lowest base 3 digit.  Blanked-out letters of the answer never match.
+int getReferencePatternCode( char guess[], char answer[])
+{
+    int unmatchedCounts[ ALPHABET_SIZE] = { 0};  // Answer letters not used by a green
+    int colors[ MAX_WORD_LENGTH] = { 0};
+    for( int j=0; j<WordLength; j++) {
+        if( guess[ j] == answer[ j]) {
+            colors[ j] = 2;
+        }
+        else if( answer[ j] != ' ') {
+            unmatchedCounts[ answer[ j] - 'a']++;
+        }
+    }
+    int code = 0;
+    int power = 1;
+    for( int j=0; j<WordLength; j++) {
+        if( colors[ j] != 2 && unmatchedCounts[ guess[ j] - 'a'] > 0) {
+            colors[ j] = 1;
+            unmatchedCounts[ guess[ j] - 'a']--;
+        }
+        code += colors[ j] * power;
+        power *= 3;
+    }
+    return code;
+} //end getReferencePatternCode(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Check each feedback pattern kernel this processor can run against getReferencePatternCode(..)
+// for every guess and answer, then the entropy and eliminated engines, plain and weighted,
+// against scores worked out from the reference patterns.  Returns 1 if they all match.
+int verifyPatternPaths(
+        benchmarkDatasetStruct *dataset,    // Words to check
+        char label[],                       // Shown before the name of each check
+        wordCountStruct *answerWords,       // Answers, which may have blanked-out letters
+        wordCountStruct *uniqueAnswers,     // The same answers, identical ones grouped
+        int *answerWeights,                 // How many answers each unique answer stands for
+        int uniqueCount)                    // How many unique answers there are
+{
+    int answersWordCount = dataset->answersWordCount;
+    int totalWordCount = dataset->totalWordCount;
+    packedAnswersStruct packed;
+    packAnswerWords( answerWords, NULL, answersWordCount, &packed);
+    patternCodeFunction kernels[ 2] = { Kernels->patternCodesScalar, NULL};
+    char *kernelNames[ 2] = { "scalar", "avx2"};
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports( "avx2")) {
+        kernels[ 1] = Kernels->patternCodesAvx2;
+    }
+#endif
+    int patternCount = Kernels->patternCount;
+    uint16_t *expectedCodes = (uint16_t *) countedMalloc( sizeof( uint16_t) * answersWordCount);
+    uint16_t *codes = (uint16_t *) countedMalloc( sizeof( uint16_t) * packed.paddedCount);
+    uint32_t *histogram = (uint32_t *) countedMalloc( sizeof( uint32_t) * patternCount);
+    wordCountStruct *expected[ 2];
+    wordCountStruct *actual = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * totalWordCount);
+    int engines[ 2] = { ENGINE_ENTROPY, ENGINE_ELIMINATED};
+    char *engineNames[ 2] = { "entropy", "eliminated"};
+    int mismatches[ 2] = { 0, 0};
+    char path[ 64];
+    int isOk = 1;
+
+    for( int e=0; e<2; e++) {
+        expected[ e] = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * totalWordCount);
+        memcpy( expected[ e], dataset->allWords, sizeof( wordCountStruct) * totalWordCount);
+    }
+    for( int i=0; i<totalWordCount; i++) {
+        char *guessWord = dataset->allWords[ i].word;
+        memset( histogram, 0, sizeof( uint32_t) * patternCount);
+        for( int a=0; a<answersWordCount; a++) {
+            expectedCodes[ a] = (uint16_t) getReferencePatternCode( guessWord, answerWords[ a].word);
+            histogram[ expectedCodes[ a]]++;
+        }
+        for( int e=0; e<2; e++) {
+            expected[ e][ i].score = getPatternHistogramScore( histogram, answersWordCount, engines[ e]);
+        }
+
+        packedGuessStruct guess;
+        packGuessWord( guessWord, &guess);
+        for( int k=0; k<2; k++) {
+            if( kernels[ k] == NULL || mismatches[ k] > 0) {
+                continue;
+            }
+            kernels[ k]( &guess, &packed, 0, packed.paddedCount, codes);
+            for( int a=0; a<answersWordCount && mismatches[ k] == 0; a++) {
+                if( codes[ a] != expectedCodes[ a]) {
+                    snprintf( path, sizeof( path), "%s pattern codes %s", label, kernelNames[ k]);
+                    printf("verify %-12s %-34s MISMATCH at %s against %s: %d instead of %d\n", dataset->name, path,
+                           guessWord, answerWords[ a].word, codes[ a], expectedCodes[ a]);
+                    mismatches[ k]++;
+                }
+            }
+        }
+    }
+    for( int k=0; k<2; k++) {
+        if( kernels[ k] != NULL && mismatches[ k] == 0) {
+            snprintf( path, sizeof( path), "%s pattern codes %s", label, kernelNames[ k]);
+            printf("verify %-12s %-34s ok\n", dataset->name, path);
+        }
+        isOk &= mismatches[ k] == 0;
+    }
+
+    // Identical answers get identical patterns, so weighting them does not change the scores
+    int savedEngine = ScoringEngine;
+    for( int e=0; e<4; e++) {
+        ScoringEngine = engines[ e % 2];
+        memcpy( actual, dataset->allWords, sizeof( wordCountStruct) * totalWordCount);
+        if( e < 2) {
+            scoreAllWords( answerWords, NULL, answersWordCount, actual, totalWordCount);
+        }
+        else {
+            scoreAllWords( uniqueAnswers, answerWeights, uniqueCount, actual, totalWordCount);
+        }
+        snprintf( path, sizeof( path), "%s engine %s%s", label, engineNames[ e % 2], e < 2 ? "" : " weighted");
+        isOk &= checkScoresMatch( dataset, path, expected[ e % 2], actual, totalWordCount);
+    }
+    ScoringEngine = savedEngine;
+
+    freePackedAnswers( &packed);
+    free( expectedCodes);
+    free( codes);
+    free( histogram);
+    free( expected[ 0]);
+    free( expected[ 1]);
+    free( actual);
+    return isOk;
+} //end verifyPatternPaths(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Check every optimized scoring path against getScore(..) for the given answers, which may
+// have blanked-out letters.  Returns 1 if they all match.
+int verifyScoringPaths( benchmarkDatasetStruct *dataset, char label[], wordCountStruct *answerWords)
+{
+    int answersWordCount = dataset->answersWordCount;
+    int totalWordCount = dataset->totalWordCount;
+    wordCountStruct *expected = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * totalWordCount);
+    wordCountStruct *actual = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * totalWordCount);
+    char path[ 64];
+    int isOk = 1;
+
+    memcpy( expected, dataset->allWords, sizeof( wordCountStruct) * totalWordCount);
+    for( int i=0; i<totalWordCount; i++) {
+        expected[ i].score = getScore( expected[ i].word, answerWords, answersWordCount);
+    }
+
+    // The same answers with identical ones grouped and weighted, as in the second-word pass
+    wordCountStruct *uniqueAnswers = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * answersWordCount);
+    int *answerWeights = (int *) countedMalloc( sizeof( int) * answersWordCount);
+    int uniqueCount = groupIdenticalAnswers( answerWords, answersWordCount, uniqueAnswers, answerWeights);
+
+    // Each packed kernel this processor can run, on the answers and on the weighted answers
+    packedAnswersStruct packed;
+    packedAnswersStruct weightedPacked;
+    packAnswerWords( answerWords, NULL, answersWordCount, &packed);
+    packAnswerWords( uniqueAnswers, answerWeights, uniqueCount, &weightedPacked);
+    packedScoreFunction kernels[ 3] = { Kernels->packedScoreScalar, NULL, NULL};
+    char *kernelNames[ 3] = { "scalar", "sse2", "avx2"};
+#ifdef HAVE_X86_SIMD
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports( "sse2")) {
+        kernels[ 1] = Kernels->packedScoreSse2;
+    }
+    if( __builtin_cpu_supports( "avx2")) {
+        kernels[ 2] = Kernels->packedScoreAvx2;
+    }
+#endif
+    for( int k=0; k<6; k++) {
+        if( kernels[ k % 3] == NULL) {
+            continue;
+        }
+        memcpy( actual, expected, sizeof( wordCountStruct) * totalWordCount);
+        for( int i=0; i<totalWordCount; i++) {
+            packedGuessStruct guess;
+            packGuessWord( actual[ i].word, &guess);
+            actual[ i].score = (int) kernels[ k % 3]( &guess, k < 3 ? &packed : &weightedPacked, NULL);
+        }
+        snprintf( path, sizeof( path), "%s packed %s%s", label, kernelNames[ k % 3], k < 3 ? "" : " weighted");
+        isOk &= checkScoresMatch( dataset, path, expected, actual, totalWordCount);
+    }
+    freePackedAnswers( &weightedPacked);
+
+    // Score matrix rows, built the same way loadOrBuildScoreMatrix(..) does
+    uint8_t *rows = (uint8_t *) countedMalloc( (size_t) totalWordCount * packed.paddedCount);
+    matrixBuildJobStruct matrixJob = { expected, &packed, answerWords, answersWordCount,
+                                       selectPackedScoreFunction(), rows, packed.paddedCount};
+    runInParallel( totalWordCount, SCORING_CHUNK_SIZE, buildScoreMatrixRows, &matrixJob);
+    for( int i=0; i<totalWordCount; i++) {
+        actual[ i].score = sumScoreMatrixRow( rows + (size_t) i * packed.paddedCount, packed.paddedCount);
+    }
+    snprintf( path, sizeof( path), "%s score matrix", label);
+    isOk &= checkScoresMatch( dataset, path, expected, actual, totalWordCount);
+    free( rows);
+    freePackedAnswers( &packed);
+
+    // Threaded engines through scoreAllWords(..)
+    int savedEngine = ScoringEngine;
+    int engines[ 2] = { ENGINE_PACKED, ENGINE_AGGREGATE};
+    char *engineNames[ 2] = { "packed", "aggregate"};
+    for( int e=0; e<4; e++) {
+        ScoringEngine = engines[ e % 2];
+        memcpy( actual, expected, sizeof( wordCountStruct) * totalWordCount);
+        if( e < 2) {
+            scoreAllWords( answerWords, NULL, answersWordCount, actual, totalWordCount);
+        }
+        else {
+            scoreAllWords( uniqueAnswers, answerWeights, uniqueCount, actual, totalWordCount);
+        }
+        snprintf( path, sizeof( path), "%s engine %s%s", label, engineNames[ e % 2], e < 2 ? "" : " weighted");
+        isOk &= checkScoresMatch( dataset, path, expected, actual, totalWordCount);
+    }
+    isOk &= verifyPatternPaths( dataset, label, answerWords, uniqueAnswers, answerWeights, uniqueCount);
+    free( uniqueAnswers);
+    free( answerWeights);
+
+    // Top word selection against a full sort, both for ties and for --top, which lists each
+    // different word once
+    qsort( expected, totalWordCount, sizeof( wordCountStruct), compareFunction);
+    wordCountStruct *distinctWords = NULL;
+    int distinctCount = getDistinctWordsByScore( expected, totalWordCount, &distinctWords);
+    int savedTopWordsCount = TopWordsCount;
+    int topCounts[ 2] = { 0, 25};
+    for( int t=0; t<2; t++) {
+        TopWordsCount = topCounts[ t];
+        memcpy( actual, dataset->allWords, sizeof( wordCountStruct) * totalWordCount);
+        wordCountStruct *bestWords = NULL;
+        int bestCount = 0;
+        findScoresAndTopWords( answerWords, NULL, answersWordCount, actual, totalWordCount, &bestWords, &bestCount);
+        wordCountStruct *expectedWords = TopWordsCount > 0 ? distinctWords : expected;
+        int expectedCount = TopWordsCount < distinctCount ? TopWordsCount : distinctCount;
+        if( TopWordsCount == 0) {
+            while( expectedCount < totalWordCount && expected[ expectedCount].score == expected[ 0].score) {
+                expectedCount++;
+            }
+        }
+        snprintf( path, sizeof( path), "%s top words (--top %d)", label, TopWordsCount);
+        if( bestCount != expectedCount) {
+            printf("verify %-12s %-34s MISMATCH: %d words instead of %d\n", dataset->name, path, bestCount, expectedCount);
+            isOk = 0;
+        }
+        else {
+            isOk &= checkScoresMatch( dataset, path, expectedWords, bestWords, bestCount);
+        }
+        free( bestWords);
+    }
+    free( distinctWords);
+    TopWordsCount = savedTopWordsCount;
+    ScoringEngine = savedEngine;
+
+    free( expected);
+    free( actual);
+    return isOk;
+} //end verifyScoringPaths(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Check the optimized scoring paths against the reference on the unchanged answers and on the
+// answers with the best first word's letters removed.  Returns 1 if everything matches.
+int verifyDataset( benchmarkDatasetStruct *dataset)
+{
+    int isOk = verifyScoringPaths( dataset, "first", dataset->answerWords);
+
+    // Residual answers as in the second-word pass, for the best first word
+    int savedEngine = ScoringEngine;
+    ScoringEngine = ENGINE_AGGREGATE;
+    wordCountStruct *bestWords = NULL;
+    int bestCount = 0;
+    wordCountStruct *allWordsCopy = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * dataset->totalWordCount);
+    memcpy( allWordsCopy, dataset->allWords, sizeof( wordCountStruct) * dataset->totalWordCount);
+    findScoresAndTopWords( dataset->answerWords, NULL, dataset->answersWordCount, allWordsCopy, dataset->totalWordCount,
+                           &bestWords, &bestCount);
+    ScoringEngine = savedEngine;
+
+    wordCountStruct *answerWordsCopy = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * dataset->answersWordCount);
+    memcpy( answerWordsCopy, dataset->answerWords, sizeof( wordCountStruct) * dataset->answersWordCount);
+    removeMatchingLetters( answerWordsCopy, dataset->answersWordCount, bestWords[ 0].word);
+    isOk &= verifyScoringPaths( dataset, "second", answerWordsCopy);
+
+    free( answerWordsCopy);
+    free( allWordsCopy);
+    free( bestWords);
+    return isOk;
+} //end verifyDataset(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Check that two lists of sequences have the same words and scores.  Displays the result and
+// returns 1 if they match.
+int checkSequencesMatch( benchmarkDatasetStruct *dataset, char path[], beamEntryStruct *expected, int expectedCount,
+                         beamEntryStruct *actual, int actualCount)
+{
+    if( actualCount != expectedCount) {
+        printf("verify %-12s %-34s MISMATCH: %d sequences instead of %d\n", dataset->name, path, actualCount, expectedCount);
+        return 0;
+    }
+    for( int i=0; i<expectedCount; i++) {
+        int isSame = actual[ i].length == expected[ i].length && actual[ i].total == expected[ i].total;
+        for( int j=0; isSame && j<expected[ i].length; j++) {
+            isSame = strcmp( actual[ i].words[ j], expected[ i].words[ j]) == 0 && actual[ i].scores[ j] == expected[ i].scores[ j];
+        }
+        if( ! isSame) {
+            printf("verify %-12s %-34s MISMATCH at %s %s: %s %s total %d instead of %d\n", dataset->name, path,
+                   expected[ i].words[ 0], expected[ i].words[ 1], actual[ i].words[ 0], actual[ i].words[ 1],
+                   actual[ i].total, expected[ i].total);
+            return 0;
+        }
+    }
+    printf("verify %-12s %-34s ok\n", dataset->name, path);
+    return 1;
+} //end checkSequencesMatch(..)
+
+
+// -----------------------------------------------------------------------------------------
+// Check the branch-and-bound pair search and the beam search at depth 2 against a brute-force
+// scan of every pair of different words, scored with getScore(..) and removeMatchingLetters(..).
+// The pair search must find every pair with the best total, and a beam as wide as the number
+// of words must keep the best pairs in compareBeamEntries(..) order.  Returns 1 if they match.
+int verifySearches( benchmarkDatasetStruct *dataset)
 {
-    FILE *inFilePtr  = fopen(fileName, "r");  // Connect logical name to filename
-    char inputString[ 81];
+    int answersWordCount = dataset->answersWordCount;
+    int totalWordCount = dataset->totalWordCount;
+    wordCountStruct *allWordsCopy = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * totalWordCount);
+    memcpy( allWordsCopy, dataset->allWords, sizeof( wordCountStruct) * totalWordCount);
+    for( int i=0; i<totalWordCount; i++) {
+        allWordsCopy[ i].score = getScore( allWordsCopy[ i].word, dataset->answerWords, answersWordCount);
+    }
+    wordCountStruct *words = NULL;
+    int wordCount = getDistinctWordsByScore( allWordsCopy, totalWordCount, &words);
 
-    // Ensure file open worked correctly
-    if( inFilePtr == NULL ) {
-        printf("Error: could not open %s for reading\n", fileName);
-        exit(-1);    // must include stdlib.h
+    // Brute force: every ordered pair of different words
+    beamEntryStruct *expected = (beamEntryStruct *) countedMalloc( sizeof( beamEntryStruct) * ((size_t) wordCount * wordCount + 1));
+    wordCountStruct *answerWordsCopy = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * answersWordCount);
+    int expectedCount = 0;
+    for( int first=0; first<wordCount; first++) {
+        memcpy( answerWordsCopy, dataset->answerWords, sizeof( wordCountStruct) * answersWordCount);
+        removeMatchingLetters( answerWordsCopy, answersWordCount, words[ first].word);
+        for( int second=0; second<wordCount; second++) {
+            if( second == first) {
+                continue;
+            }
+            beamEntryStruct *sequence = &expected[ expectedCount++];
+            memset( sequence, 0, sizeof( beamEntryStruct));
+            strcpy( sequence->words[ 0], words[ first].word);
+            strcpy( sequence->words[ 1], words[ second].word);
+            sequence->scores[ 0] = words[ first].score;
+            sequence->scores[ 1] = getScore( words[ second].word, answerWordsCopy, answersWordCount);
+            sequence->length = 2;
+            sequence->total = sequence->scores[ 0] + sequence->scores[ 1];
+        }
     }
+    qsort( expected, expectedCount, sizeof( beamEntryStruct), compareBeamEntries);
+    int isOk = 1;
 
-    // Read from file.  For validation display only the first group of words.
-    int wordsCounter = 0;
-    while( fscanf( inFilePtr, "%s", inputString) != EOF) {
-        wordsCounter++;
+    // Pair search, with its best pairs put in the same order
+    pairSearchStruct search;
+    wordCountStruct *pairWords = NULL;
+    int pairWordCount = findBestPairs( dataset->answerWords, answersWordCount, allWordsCopy, totalWordCount,
+                                       &search, &pairWords);
+    beamEntryStruct *actual = (beamEntryStruct *) countedMalloc( sizeof( beamEntryStruct) * (search.bestPairCount + 1));
+    for( int i=0; i<search.bestPairCount; i++) {
+        wordPairStruct *pair = &search.bestPairs[ i];
+        memset( &actual[ i], 0, sizeof( beamEntryStruct));
+        strcpy( actual[ i].words[ 0], pairWords[ pair->firstIndex].word);
+        strcpy( actual[ i].words[ 1], pairWords[ pair->secondIndex].word);
+        actual[ i].scores[ 0] = pairWords[ pair->firstIndex].score;
+        actual[ i].scores[ 1] = pair->secondScore;
+        actual[ i].length = 2;
+        actual[ i].total = search.bestTotal;
     }
+    qsort( actual, search.bestPairCount, sizeof( beamEntryStruct), compareBeamEntries);
+    int bestCount = 0;
+    while( bestCount < expectedCount && expected[ bestCount].total == expected[ 0].total) {
+        bestCount++;
+    }
+    isOk &= checkSequencesMatch( dataset, "pair search", expected, pairWordCount < 2 ? 0 : bestCount,
+                                 actual, search.bestPairCount);
+    free( search.bestPairs);
+    free( pairWords);
+    free( actual);
 
-    // Close the file
-    fclose( inFilePtr);
+    // Beam search at depth 2, wide enough to be exhaustive
+    int savedBeamWidth = BeamWidth;
+    int savedBeamDepth = BeamDepth;
+    BeamWidth = wordCount > 0 ? wordCount : 1;
+    BeamDepth = 2;
+    int beamSize = findBestSequences( dataset->answerWords, answersWordCount, allWordsCopy, totalWordCount, &actual);
+    BeamWidth = savedBeamWidth;
+    BeamDepth = savedBeamDepth;
+    isOk &= checkSequencesMatch( dataset, "beam search, depth 2", expected, expectedCount < wordCount ? expectedCount : wordCount,
+                                 actual, beamSize);
+    free( actual);
 
-    return wordsCounter;
-} // end countWordsInFile(..)
+    free( expected);
+    free( answerWordsCopy);
+    free( words);
+    free( allWordsCopy);
+    return isOk;
+} //end verifySearches(..)
 
 
-//-----------------------------------------------------------------------------------------
-// Read file and one at a time append all the words from that file into the array.
-void appendWordsFromFileToArray(
-            char fileName[],        // Filename we'll read from
-            wordCountStruct *words, // Array of words where we'll store words we read from file
-            int startingIndex)      // Starting index into which we will store words.  This is
-                                    // needed when we are appending the guesses words to the
-                                    // array of already stored answer words, giving all words.
+// -----------------------------------------------------------------------------------------
+// Check that a list of best words has the expected number of words, with the same words and
+// scores.  Displays the result and returns 1 if they match.
+int checkBestWordsMatch( benchmarkDatasetStruct *dataset, char path[], wordCountStruct *expected, int expectedCount,
+                         wordCountStruct *actual, int actualCount)
 {
-    FILE *inFilePtr  = fopen(fileName, "r");  // Connect logical name to filename
-    char inputString[ 81];
-
-    // Sanity check: ensure file open worked correctly
-    if( inFilePtr == NULL ) {
-        printf("Error: could not open %s for reading\n", fileName);
-        exit(-1);    // must include stdlib.h
+    if( actualCount != expectedCount) {
+        printf("verify %-12s %-34s MISMATCH: %d words instead of %d\n", dataset->name, path, actualCount, expectedCount);
+        return 0;
     }
+    return checkScoresMatch( dataset, path, expected, actual, actualCount);
+} //end checkBestWordsMatch(..)
 
-    // Read each word from file and store into array, initializing the score for that word to 0.
-    int index = startingIndex;
-    while( fscanf( inFilePtr, "%s", inputString) != EOF) {
-        strcpy( words[ index].word, inputString);
-        words[ index].score = 0;
-        index++;
-    }
 
-    // Close the file
-    fclose( inFilePtr);
-} // end appendWordsFromFileToArray(..)
+// -----------------------------------------------------------------------------------------
+// Check the --mem-cap streaming passes against the in-memory ones for the best first words
+// and the best second words after the best first word, both for ties and for --top.  The
+// cap leaves room for only a few chunks of words at a time, so the words of the given files
+// are scored over several tiles whose best words are merged.  Returns 1 if they all match.
+int verifyStreaming(
+        benchmarkDatasetStruct *dataset,    // Dataset read from the files below
+        char answersFileName[],             // Name of the answers file
+        char guessesFileName[])             // Name of the guesses file
+{
+    int answersWordCount = dataset->answersWordCount;
+    int totalWordCount = dataset->totalWordCount;
+    wordCountStruct *allWordsCopy = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * totalWordCount);
+    wordCountStruct *answerWordsCopy = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * answersWordCount);
+    char path[ 64];
+    int isOk = 1;
 
+    int savedTopWordsCount = TopWordsCount;
+    int topCounts[ 2] = { 0, 25};
+    for( int t=0; t<2; t++) {
+        // The stream's buffers for merging best words are sized by TopWordsCount
+        TopWordsCount = topCounts[ t];
+        wordStreamStruct stream;
+        long memoryCap = getStreamAnswerBytes( answersWordCount) + 16L * SCORING_CHUNK_SIZE * STREAM_BYTES_PER_WORD;
+        openWordStream( &stream, answersFileName, guessesFileName, memoryCap);
 
-//-----------------------------------------------------------------------------------------
-// Read in words from files into arrays, displaying how many words there are in each file.
-// The number of words in each file was previously calculated, and space was dynamically
-// allocated for each of the arrays.
-void readInWordsAndDisplayNumbers(
-        wordCountStruct *answerWords,   // Array of the answer words
-        int answersWordCount,           // How many words there are in answerWords
-        wordCountStruct *allWords,      // Array of all the words
-        int totalWordCount,             // How many words there are in allWords
-        int guessesWordCount,           // How many words there are in the guesses
-        char answersFileName[],         // Name of the answers file
-        char guessesFileName[])         // Name of the guesses file
-{
-    char fileName[ 81];         // Will be reused for different file names.
-
-    // Read all the words from the answers and guesses files, this time storing them
-    // in our newly allocated arrays. As we go display the total number of words in each file.
-    strcpy( fileName, answersFileName);
-    // Add the answers words to both arrays, starting at index 0
-    appendWordsFromFileToArray( fileName, answerWords, 0);
-    appendWordsFromFileToArray( fileName, allWords, 0);
-    printf("%s has %d words\n", fileName, answersWordCount);    // Display word counts
-
-    // Append the guesses words to the allWords array as well, starting at index answersWordCount,
-    // which should be the next open spot into which the next word can be stored.
-    strcpy( fileName, guessesFileName);
-    appendWordsFromFileToArray( fileName, allWords, answersWordCount);
-    printf("%s has %d words\n", fileName, guessesWordCount);    // Display word counts
-} //end readInWordsAndDisplayNumbers(..)
+        memcpy( allWordsCopy, dataset->allWords, sizeof( wordCountStruct) * totalWordCount);
+        wordCountStruct *expected = NULL;
+        int expectedCount = 0;
+        findScoresAndTopWords( dataset->answerWords, NULL, answersWordCount, allWordsCopy, totalWordCount,
+                               &expected, &expectedCount);
+        wordCountStruct *actual = NULL;
+        int actualCount = 0;
+        findScoresAndTopWordsStreaming( &stream, stream.answerWords, NULL, stream.answersWordCount,
+                                        &actual, &actualCount);
+        snprintf( path, sizeof( path), "streaming first (--top %d)", TopWordsCount);
+        isOk &= checkBestWordsMatch( dataset, path, expected, expectedCount, actual, actualCount);
 
+        wordCountStruct *expectedSecond = NULL;
+        int expectedSecondCount = 0;
+        memcpy( allWordsCopy, dataset->allWords, sizeof( wordCountStruct) * totalWordCount);
+        findBestSecondWords( dataset->answerWords, answersWordCount, allWordsCopy, totalWordCount, expected[ 0].word,
+                             answerWordsCopy, &expectedSecond, &expectedSecondCount);
+        wordCountStruct *actualSecond = NULL;
+        int actualSecondCount = 0;
+        findBestSecondWordsStreaming( &stream, expected[ 0].word, &actualSecond, &actualSecondCount);
+        snprintf( path, sizeof( path), "streaming second (--top %d)", TopWordsCount);
+        isOk &= checkBestWordsMatch( dataset, path, expectedSecond, expectedSecondCount, actualSecond, actualSecondCount);
 
-//-----------------------------------------------------------------------------------------
-// Calculate the word comparison score, where it gets:
-//   - One point for each correct letter in an incorrect position
-//   - Three points for each correct letter in the correct position
-int getSingleWordComparisonScore( char originalWordParameter[], char comparisonWordParameter[])
-{
-    // Make copies of words, to use in blanking out letters that have already contributed
-    // to scoring.
-    char originalWord[ WORD_LENGTH + 1];
-    char comparisonWord[ WORD_LENGTH + 1];
-    strcpy( originalWord, originalWordParameter);
-    strcpy( comparisonWord, comparisonWordParameter);
+        free( expected);
+        free( actual);
+        free( expectedSecond);
+        free( actualSecond);
+        closeWordStream( &stream);
+    }
+    TopWordsCount = savedTopWordsCount;
 
-    int score = 0;    // Accumulates word score
+    free( allWordsCopy);
+    free( answerWordsCopy);
+    return isOk;
+} //end verifyStreaming(..)
 
-    // Find exact matches
-    for( int i=0; i<WORD_LENGTH; i++) {
-        // Accumulate score for exact letter match, and blank out letter so it is
-        // not reused.
-        if( originalWord[ i] == comparisonWord[ i] ) {
-            score += 3;     // Points for a matching letter in the same position
-            originalWord[ i] = ' ';
-            comparisonWord[ i] = ' ';
-        }
-    }
 
-    // Find matching letter in a different position.  Letters that were exact
-    // matches have already been blanked out.
-    for( int i=0; i<WORD_LENGTH; i++) {
-        char c = originalWord[ i];
-        // Only consider non-blanks
-        if( c != ' ') {
-            // Step through each possible matching character.
-            for( int j=0; j<WORD_LENGTH; j++) {
-                // Accumulate score for exact letter match, and blank out letter so it is
-                // not reused. After a match is found, break out of comparison loop so that
-                // letter does not count for scoring more than once.
-                if( c == comparisonWord[ j]) {
-                    score += 1;
-                    originalWord[ i] = ' ';
-                    comparisonWord[ j] = ' ';
-                    break;
-                }
-            } //end for( int j ...)
-        } //end if( c...
-    } //end for( int i...
+// -----------------------------------------------------------------------------------------
+// Check the second-word passes run as separate tasks, as for tied first words, against the
+// same passes run one after another, for the six best first words on three scoring threads
+// so the tasks run at the same time.  Returns 1 if they all match.
+int verifySecondWordTasks( benchmarkDatasetStruct *dataset)
+{
+    int answersWordCount = dataset->answersWordCount;
+    int totalWordCount = dataset->totalWordCount;
+    wordCountStruct *allWordsCopy = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * totalWordCount);
+    wordCountStruct *answerWordsCopy = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * answersWordCount);
+    memcpy( allWordsCopy, dataset->allWords, sizeof( wordCountStruct) * totalWordCount);
+    int savedTopWordsCount = TopWordsCount;
+    int savedNumberOfThreads = NumberOfThreads;
+    TopWordsCount = 6;
+    wordCountStruct *bestWords = NULL;
+    int bestCount = 0;
+    findScoresAndTopWords( dataset->answerWords, NULL, answersWordCount, allWordsCopy, totalWordCount,
+                           &bestWords, &bestCount);
 
-    return score;
-} //end getSingleWordComparisonScore(..)
+    // Tied second words, as in the default search
+    TopWordsCount = 0;
+    NumberOfThreads = 3;
+    secondWordSearchStruct search;
+    findAllBestSecondWords( &search, dataset->answerWords, answersWordCount, allWordsCopy, totalWordCount,
+                            bestWords, bestCount, 0);
+    char path[ 64];
+    int isOk = 1;
+    for( int i=0; i<bestCount; i++) {
+        wordCountStruct *expected = NULL;
+        int expectedCount = 0;
+        findBestSecondWords( dataset->answerWords, answersWordCount, allWordsCopy, totalWordCount, bestWords[ i].word,
+                             answerWordsCopy, &expected, &expectedCount);
+        snprintf( path, sizeof( path), "second-word task after %s", bestWords[ i].word);
+        isOk &= checkBestWordsMatch( dataset, path, expected, expectedCount,
+                                     search.bestSecondWords[ i], search.secondWordCounts[ i]);
+        free( expected);
+        free( search.bestSecondWords[ i]);
+    }
+    TopWordsCount = savedTopWordsCount;
+    NumberOfThreads = savedNumberOfThreads;
 
+    free( search.bestSecondWords);
+    free( search.secondWordCounts);
+    free( bestWords);
+    free( allWordsCopy);
+    free( answerWordsCopy);
+    return isOk;
+} //end verifySecondWordTasks(..)
 
-//-----------------------------------------------------------------------------------------
-// For the given word, calculate its score by comparing how well it matches each answer word.
-int getScore( char theGuess[],              // Word being evaluated as a guess
-              wordCountStruct *answerWords, // All the answer words, which theGuess is compared against
-              int answersWordCount)         // Number of words in answers file
+
+// -----------------------------------------------------------------------------------------
+// Time the scoring hot path and the full first- and second-word passes on one dataset.
+void benchmarkDataset( benchmarkDatasetStruct *dataset)
 {
-    int score = 0;
-    for( int i=0; i<answersWordCount; i++) {
-        score += getSingleWordComparisonScore( theGuess, answerWords[ i].word);
+    int answersWordCount = dataset->answersWordCount;
+    int totalWordCount = dataset->totalWordCount;
+    struct timespec start;
+    volatile long sink = 0;     // Keeps the compiler from skipping the work being timed
+
+    // Single comparisons: cycle through pairs until about a million comparisons are done
+    long comparisons = 1000000;
+    clock_gettime( CLOCK_MONOTONIC, &start);
+    for( long i=0; i<comparisons; i++) {
+        sink += getSingleWordComparisonScore( dataset->allWords[ i % totalWordCount].word,
+                                              dataset->answerWords[ (i * 7) % answersWordCount].word);
     }
-    return score;
-}
+    displayBenchmarkResult( dataset, "getSingleWordComparisonScore", getElapsedSeconds( &start), comparisons);
 
+    // getScore and the packed kernel, on enough guesses for about ten million comparisons
+    int guessCount = 10000000 / answersWordCount + 1;
+    if( guessCount > totalWordCount) {
+        guessCount = totalWordCount;
+    }
+    clock_gettime( CLOCK_MONOTONIC, &start);
+    for( int i=0; i<guessCount; i++) {
+        sink += getScore( dataset->allWords[ i].word, dataset->answerWords, answersWordCount);
+    }
+    displayBenchmarkResult( dataset, "getScore", getElapsedSeconds( &start), (double) guessCount * answersWordCount);
 
-//-----------------------------------------------------------------------------------------
-// Comparator for use in built-in qsort(..) function.  Parameters are declared to be a
-// generic type, so they will match with anything.
-// This is a two-part comparison.  First the scores are compared.  If they are the same,
-// then the words themselves are also compared, so that the results are in descending
-// order by score, and within score they are in alphabetic order.
-int compareFunction( const void * a, const void * b) {
-    // Before using parameters we have cast them into the actual type they are in our program
-    // and then extract the numerical value used in comparison
-    int firstScore = ((wordCountStruct *) a)->score;
-    int secondScore = ((wordCountStruct *) b)->score;
+    packedAnswersStruct packed;
+    packAnswerWords( dataset->answerWords, NULL, answersWordCount, &packed);
+    packedScoreFunction packedScore = selectPackedScoreFunction();
+    clock_gettime( CLOCK_MONOTONIC, &start);
+    for( int i=0; i<guessCount; i++) {
+        packedGuessStruct guess;
+        packGuessWord( dataset->allWords[ i].word, &guess);
+        sink += packedScore( &guess, &packed, NULL);
+    }
+    displayBenchmarkResult( dataset, "packed kernel (one thread)", getElapsedSeconds( &start), (double) guessCount * answersWordCount);
+    freePackedAnswers( &packed);
 
-    // If scores are different, then that's all we need for our comparison.
-    if (firstScore != secondScore) {
-        // We reverse the values, so the result is in descending vs. the otherwise ascending order
-        // return firstScore - secondScore;   // ascending order
-        return secondScore - firstScore;      // descending order
+    // removeMatchingLetters over all answers, repeated for about ten million answers
+    wordCountStruct *answerWordsCopy = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * answersWordCount);
+    int repeatCount = 10000000 / answersWordCount + 1;
+    double seconds = 0.0;
+    for( int r=0; r<repeatCount; r++) {
+        memcpy( answerWordsCopy, dataset->answerWords, sizeof( wordCountStruct) * answersWordCount);
+        clock_gettime( CLOCK_MONOTONIC, &start);
+        removeMatchingLetters( answerWordsCopy, answersWordCount, dataset->allWords[ r % totalWordCount].word);
+        seconds += getElapsedSeconds( &start);
     }
-    else {
-        // Scores are equal, so check words themselves, to put them in alphabetical order
-        return strcmp( ((wordCountStruct *)a)->word,  ((wordCountStruct *)b)->word );
+    displayBenchmarkResult( dataset, "removeMatchingLetters", seconds, (double) repeatCount * answersWordCount);
+
+    // Full first- and second-word passes with each engine, skipping those that would take too long
+    int savedEngine = ScoringEngine;
+    int engines[ 3] = { ENGINE_REFERENCE, ENGINE_PACKED, ENGINE_AGGREGATE};
+    char *engineNames[ 3] = { "reference", "packed", "aggregate"};
+    long limits[ 3] = { BENCHMARK_MAX_REFERENCE_PAIRS, BENCHMARK_MAX_PACKED_PAIRS, LONG_MAX};
+    wordCountStruct *allWordsCopy = (wordCountStruct *) countedMalloc( sizeof( wordCountStruct) * totalWordCount);
+    char benchmark[ 64];
+    double pairs = (double) totalWordCount * answersWordCount;
+    for( int e=0; e<3; e++) {
+        if( pairs > limits[ e]) {
+            continue;
+        }
+        ScoringEngine = engines[ e];
+        memcpy( allWordsCopy, dataset->allWords, sizeof( wordCountStruct) * totalWordCount);
+        wordCountStruct *bestWords = NULL;
+        int bestCount = 0;
+        clock_gettime( CLOCK_MONOTONIC, &start);
+        findScoresAndTopWords( dataset->answerWords, NULL, answersWordCount, allWordsCopy, totalWordCount, &bestWords, &bestCount);
+        snprintf( benchmark, sizeof( benchmark), "first-word pass, %s", engineNames[ e]);
+        displayBenchmarkResult( dataset, benchmark, getElapsedSeconds( &start), pairs);
+
+        wordCountStruct *bestSecondWords = NULL;
+        int bestSecondCount = 0;
+        clock_gettime( CLOCK_MONOTONIC, &start);
+        findBestSecondWords( dataset->answerWords, answersWordCount, allWordsCopy, totalWordCount, bestWords[ 0].word,
+                             answerWordsCopy, &bestSecondWords, &bestSecondCount);
+        snprintf( benchmark, sizeof( benchmark), "second-word pass, %s", engineNames[ e]);
+        displayBenchmarkResult( dataset, benchmark, getElapsedSeconds( &start), pairs);
+        free( bestWords);
+        free( bestSecondWords);
     }
-} //end compareFunction(..)
+    ScoringEngine = savedEngine;
+    free( allWordsCopy);
+    free( answerWordsCopy);
+} //end benchmarkDataset(..)
 
 
 // -----------------------------------------------------------------------------------------
-// Find the score for each word in the allWords array by comparing it against all the words
-// in answerWords and accumulating values for matching letters.
-// Find the number of top-scoring words, returning this value through the reference parameter.
-void findScoresAndTopWords(
-        wordCountStruct *answerWords,   // Array of the answer words
-        int answersWordCount,           // How many words there are in answerWords
-        wordCountStruct *allWords,      // Array of all the words
-        int totalWordCount,             // How many words there are in allWords
-        wordCountStruct * *bestWords,   // Array to be allocated to store best words
-        int *numberOfTopScoringWords)   // How many words are tied with top score value
+// Verify the optimized paths against the reference scorer on the Tiny and Large word files
+// and on synthetic dictionaries 10 and 100 times the size of Large, then, if isBenchmark is
+// set, time them too.  Large paths are only verified on the smaller datasets.
+// Returns 1 if every check passed.
+int runVerifyAndBenchmarks( int isBenchmark)
 {
-    // For each word in the allWords array, calculate its score to represent how good of a job
-    // it does on average at matching letters from the answer words.  The struct used to
-    // store words has space for the 5-letter word as well as for that word's score.
-    for( int i=0; i<totalWordCount; i++) {
-        allWords[ i].score =  getScore( allWords[ i].word, answerWords, answersWordCount);
-    }
+    benchmarkDatasetStruct datasets[ 4];
+    makeBenchmarkDataset( &datasets[ 0], "tiny", "answersTiny.txt", "guessesTiny.txt", NULL, 1);
+    makeBenchmarkDataset( &datasets[ 1], "large", "answersLarge.txt", "guessesLarge.txt", NULL, 1);
+    makeBenchmarkDataset( &datasets[ 2], "large x10", NULL, NULL, &datasets[ 1], 10);
+    makeBenchmarkDataset( &datasets[ 3], "large x100", NULL, NULL, &datasets[ 1], 100);
 
-    // Sort the allWords array in descending order by score, and within score they should also
-    // be sorted into ascending order alphabetically.  Use the built-in C quick sort qsort(...).
-    // The last parameter is the name of the comparison function we use (a function pointer).
-    qsort( allWords, totalWordCount, sizeof( wordCountStruct), compareFunction);
+    // The reference scorer is too slow for every pair of the big synthetic sets, so those are
+    // verified on a slice of their guesses.
+    benchmarkDatasetStruct slice = datasets[ 2];
+    snprintf( slice.name, sizeof( slice.name), "x10 slice");
+    slice.totalWordCount = slice.answersWordCount + 2000;
 
-    // Retrieve the top score and count the number of words that all share that top score.
-    int topScore = allWords[ 0].score;
-    int index = 0;
-    while( allWords[ index].score == topScore) {
-        index++;
-    }
-    *numberOfTopScoringWords = index;
+    int isOk = verifyDataset( &datasets[ 0]) & verifyDataset( &datasets[ 1]) & verifyDataset( &slice);
 
-    // Allocate memory for the best words array and store words into it.
-    *bestWords = (wordCountStruct *) malloc( sizeof( wordCountStruct) * *numberOfTopScoringWords);
-    for( int i=0; i < *numberOfTopScoringWords; i++) {
-        strcpy( (*bestWords)[ i].word, allWords[ i].word);   // Store
-        (*bestWords)[ i].score = topScore;
-    }
+    // The searches are checked against every pair, so only on the Tiny words and on the first
+    // answers and words of Large
+    benchmarkDatasetStruct searchSlice = datasets[ 1];
+    snprintf( searchSlice.name, sizeof( searchSlice.name), "large slice");
+    searchSlice.answersWordCount = 100;
+    searchSlice.totalWordCount = 300;
+    isOk &= verifySearches( &datasets[ 0]) & verifySearches( &searchSlice);
 
-    // For debugging set global value DebugOn to 1
-    if( DebugOn) {
-        // For debugging display all words in descending order
-        printf("All words in descending order by score:\n");
-        for (int i = 0; i < totalWordCount; i++) {
-            printf("%d %s\n", allWords[ i].score, allWords[ i].word);   // Display
+    // Streaming reads the words from their files, so only the datasets read from files
+    isOk &= verifyStreaming( &datasets[ 0], "answersTiny.txt", "guessesTiny.txt")
+            & verifyStreaming( &datasets[ 1], "answersLarge.txt", "guessesLarge.txt");
+    isOk &= verifySecondWordTasks( &datasets[ 0]) & verifySecondWordTasks( &datasets[ 1]);
+    printf( isOk ? "All optimized paths match the reference scorer\n" : "Some optimized paths do not match the reference scorer\n");
+
+    if( isBenchmark) {
+        printf("\nBenchmarks with %d scoring threads:\n", getScoringThreadCount());
+        for( int d=0; d<4; d++) {
+            benchmarkDataset( &datasets[ d]);
         }
     }
-    
-    if( DebugOn) {
-        // For debugging display the top scoring words
-        printf("Top scoring words:\n");
-        for (int i = 0; i < *numberOfTopScoringWords; i++) {
-            printf("%s %d\n", (*bestWords)[i].word, (*bestWords)[i].score);   // Display
-        }
+    for( int d=0; d<4; d++) {
+        freeBenchmarkDataset( &datasets[ d]);
     }
-} //end findScoresAndTopWords(..)
+    return isOk;
+} //end runVerifyAndBenchmarks(..)
 
 
 // -----------------------------------------------------------------------------------------
-// Go through the array of answerWordsCopy.  For each word, remove the letters that were already
-// handled with the bestWord, so we are only scoring on letters from the second move and
-// not (again) from first move letters represented by bestWord.
-void removeMatchingLetters(
-        wordCountStruct *answerWordsCopy, // Copy of the answerWords
-        int answersWordCount,             // How many words in the allWords array
-        char bestWord[ ])                 // The best word
+// Return the scoring engine with the given name, or -1 if there is no such engine.
+int getScoringEngineByName( char name[])
 {
-    // Go through each word in answerWordsCopy
-    for( int i=0; i<answersWordCount; i++) {
-        // For the current (ith) answerWordsCopy word, step through each (jth) letter in bestWord
-        
-        // Make a copy of the best word
-        char bestWordCopy[ 6];
-        strcpy( bestWordCopy, bestWord);
-        
-        // First blank out matching letters in the same position.
-        for( int j=0; j<WORD_LENGTH; j++) {
-            // Compare the bestWord letter[ j] to the answersWordsCopy[ j] letter.
-            if( bestWordCopy[ j] == answerWordsCopy[ i].word[ j] ) {
-                // Blank out matching letters, so they can't be reused
-                bestWordCopy[ j] = ' ';
-                answerWordsCopy[ i].word[ j] = ' ';
-            }
-        }
-                
-        // Next blank out matching letters in different positions.
-        for( int j=0; j<WORD_LENGTH; j++) {
-            // Compare the current (jth) bestWord letter to each answersWordsCopy (kth) letter.
-            for( int k=0; k<WORD_LENGTH; k++) {
-                // If a match is found, blank out the answersWordsCopy letter so it will not contribute to scoring
-               if( bestWordCopy[ j] == answerWordsCopy[ i].word[ k] ) {
-                   answerWordsCopy[ i].word[ k] = ' ';
-                   break;   // Go on to next (jth) letter in the bestWordCopy
-               }
-            } //end for( int k...
-        } //end for( int j...
-    } //end for( int i...
-
-} //end removeMatchingLetters(..)
+    if( strcmp( name, "packed") == 0)    return ENGINE_PACKED;
+    if( strcmp( name, "aggregate") == 0) return ENGINE_AGGREGATE;
+    if( strcmp( name, "reference") == 0) return ENGINE_REFERENCE;
+    if( strcmp( name, "entropy") == 0)   return ENGINE_ENTROPY;
+    if( strcmp( name, "eliminated") == 0) return ENGINE_ELIMINATED;
+    return -1;
+} //end getScoringEngineByName(..)
 
 
 // -----------------------------------------------------------------------------------------
-// Find the set of best second words, once the letters from the first words are taken out
-// of the way.
-void findAndDisplayBestSecondWords(
-        wordCountStruct *answerWords,   // The set of answer words
-        int answersWordCount,           // How many answer words there are
-        wordCountStruct *allWords,      // The set of all words
-        int totalWordCount,             // How many allWords there are
-        wordCountStruct *bestWords,     // The set of best first words
-        int bestWordIndex)              // Index of current best word being used to find best
-                                        //   second words.
+// Return the number of bytes given by text such as 500000, 64K, 200M or 2G, or -1 if it is
+// not a positive number of bytes.
+long getByteCount( char text[])
 {
-    char bestWord[ 81];        // The best first word used this round to find best second words.
-    strcpy( bestWord, bestWords[ bestWordIndex].word);
-    int bestWordScore = bestWords[ bestWordIndex].score;
-
-    // Make a copy of answerWords, zeroing out its scores and eliminating the first occurrence
-    // of all characters found in the current top-scoring word.
-    // First allocate space for the copy.
-    wordCountStruct *answerWordsCopy = (wordCountStruct *) malloc( sizeof( wordCountStruct) * answersWordCount);
-
-    // Copy the original words into answerWordsCopy, and zero-out scores in the copy
-    for( int j=0; j<answersWordCount; j++) {
-        strcpy( answerWordsCopy[ j].word, answerWords[ j].word);
-        answerWordsCopy[ j].score = 0;
+    char *end = NULL;
+    long count = strtol( text, &end, 10);
+    long multiplier = 1;
+    if( *end == 'K' || *end == 'k') multiplier = 1L << 10;
+    if( *end == 'M' || *end == 'm') multiplier = 1L << 20;
+    if( *end == 'G' || *end == 'g') multiplier = 1L << 30;
+    if( multiplier > 1) {
+        end++;
     }
+    if( end == text || *end != '\0' || count <= 0 || count > LONG_MAX / multiplier) {
+        return -1;
+    }
+    return count * multiplier;
+} //end getByteCount(..)
 
-    // Remove single letters matching those in the current best word under consideration
-    removeMatchingLetters( answerWordsCopy, answersWordCount, bestWord);
 
-    // For each word in allWords find its score by comparing to all answerWordsCopy.
-    // Sort and find top scoring words.
-    int numberOfTopScoringSecondWords = 0;
-    wordCountStruct *bestSecondWords = NULL;  // Will be allocated in function below
-    findScoresAndTopWords( answerWordsCopy, answersWordCount,
-                           allWords, totalWordCount,
-                           &bestSecondWords, &numberOfTopScoringSecondWords);
+// -----------------------------------------------------------------------------------------
+int main( int argc, char *argv[]) {
+    char answersFileName[ 1024];  // Stores the answers file name
+    char guessesFileName[ 1024];  // Stores the guesses file name
+    // Global macros for filenames are provided at program top, for convenience in changing.
+    strcpy(answersFileName, ANSWERS_FILE_NAME);
+    strcpy(guessesFileName, GUESSES_FILE_NAME);
+    char *batchMode = NULL;       // Mode given with --mode, run instead of the menu
+    int isServer = 0;             // Set with --serve
+    char *socketPath = NULL;      // Set with --socket PATH
+    int isEngineChosen = 0;       // Set when --engine is given
+    char *guesses[ 32];           // Guesses and feedback given with --feedback, for filter mode
+    char *feedbacks[ 32];
+    int feedbackCount = 0;
+    int isVerify = 0;             // Set with --verify
+    int isBenchmark = 0;          // Set with --bench
 
-    if( DebugOn) {
-        // For debugging display allWordsCopy, with letters from bestWord removed
-        printf("answerWordsCopy after letters from %s removed:\n", bestWord);
-        for (int j = 0; j < answersWordCount; j++) {
-            printf("%2d. %s\n", j, answerWordsCopy[j].word);
+    // Optional command line arguments to choose the number of scoring threads, the scoring
+    // engine, a score matrix cache file and how many top words to show, e.g. --threads 4 --top 10.
+    // Giving --mode or --serve runs without the menu, for use from scripts.
+    for( int i=1; i<argc; i++) {
+        if( (strcmp( argv[ i], "--threads") == 0 || strcmp( argv[ i], "-t") == 0) && i+1 < argc) {
+            NumberOfThreads = atoi( argv[ ++i]);
         }
-
-        // For debugging display all words and scores
-        printf("    Words and scores:\n");
-        for (int i = 0; i < totalWordCount; i++) {
-            printf("    %s %d \n", allWords[i].word, allWords[i].score);
+        else if( (strcmp( argv[ i], "--cache") == 0 || strcmp( argv[ i], "-c") == 0) && i+1 < argc) {
+            ScoreMatrixFileName = argv[ ++i];
         }
-    } //end if( DebugOn)
+        else if( strcmp( argv[ i], "--beam-width") == 0 && i+1 < argc && atoi( argv[ i+1]) > 0) {
+            BeamWidth = atoi( argv[ ++i]);
+        }
+        else if( strcmp( argv[ i], "--beam-depth") == 0 && i+1 < argc && atoi( argv[ i+1]) > 0) {
+            BeamDepth = atoi( argv[ ++i]);
+        }
+        else if( strcmp( argv[ i], "--top") == 0 && i+1 < argc) {
+            TopWordsCount = atoi( argv[ ++i]);
+        }
+        else if( strcmp( argv[ i], "--mem-cap") == 0 && i+1 < argc && getByteCount( argv[ i+1]) > 0) {
+            MemoryCap = getByteCount( argv[ ++i]);
+        }
+        else if( (strcmp( argv[ i], "--engine") == 0 || strcmp( argv[ i], "-e") == 0) && i+1 < argc
+                 && getScoringEngineByName( argv[ i+1]) >= 0) {
+            ScoringEngine = getScoringEngineByName( argv[ ++i]);
+            isEngineChosen = 1;
+        }
+        else if( strcmp( argv[ i], "--answers") == 0 && i+1 < argc && strlen( argv[ i+1]) < sizeof( answersFileName)) {
+            strcpy( answersFileName, argv[ ++i]);
+        }
+        else if( strcmp( argv[ i], "--guesses") == 0 && i+1 < argc && strlen( argv[ i+1]) < sizeof( guessesFileName)) {
+            strcpy( guessesFileName, argv[ ++i]);
+        }
+        else if( strcmp( argv[ i], "--mode") == 0 && i+1 < argc
+                 && (strcmp( argv[ i+1], "first") == 0 || strcmp( argv[ i+1], "second") == 0
+                     || strcmp( argv[ i+1], "pairs") == 0 || strcmp( argv[ i+1], "beam") == 0
+                     || strcmp( argv[ i+1], "filter") == 0)) {
+            batchMode = argv[ ++i];
+        }
+        else if( strcmp( argv[ i], "--feedback") == 0 && i+2 < argc && feedbackCount < 32) {
+            guesses[ feedbackCount] = argv[ ++i];
+            feedbacks[ feedbackCount++] = argv[ ++i];
+        }
+        else if( strcmp( argv[ i], "--format") == 0 && i+1 < argc
+                 && (strcmp( argv[ i+1], "plain") == 0 || strcmp( argv[ i+1], "json") == 0)) {
+            OutputFormat = strcmp( argv[ ++i], "json") == 0 ? FORMAT_JSON : FORMAT_PLAIN;
+        }
+        else if( strcmp( argv[ i], "--verify") == 0) {
+            isVerify = 1;
+        }
+        else if( strcmp( argv[ i], "--bench") == 0) {
+            isBenchmark = 1;
+        }
+        else if( strcmp( argv[ i], "--debug") == 0) {
+            DebugOn = 1;
+        }
+        else if( strcmp( argv[ i], "--profile") == 0) {
+            ProfileOn = 1;
+        }
+        else if( strcmp( argv[ i], "--serve") == 0) {
+            isServer = 1;
+        }
+        else if( strcmp( argv[ i], "--socket") == 0 && i+1 < argc) {
+            isServer = 1;
+            socketPath = argv[ ++i];
+        }
+        else {
+            printf("Usage: %s [--threads N] [--engine packed|aggregate|reference|entropy|eliminated] [--cache FILE] [--top N]\n"
+                   "       [--beam-width N] [--beam-depth N] [--mem-cap BYTES[K|M|G]]\n"
+                   "       [--answers FILE] [--guesses FILE] [--format plain|json]\n"
+                   "       [--mode first|second|pairs|beam|filter [--feedback GUESS FEEDBACK]...]\n"
+                   "       [--serve | --socket PATH] [--verify] [--bench] [--profile] [--debug]\n", argv[ 0]);
+            exit(-1);
+        }
+    }
 
-    // Display the top scoring first and second words
-    printf("%s %d\n", bestWord, bestWordScore);
-    for (int i = 0; i < numberOfTopScoringSecondWords; i++) {
-        printf("   %s %d", bestSecondWords[i].word, bestSecondWords[i].score);
+    // With --profile, time everything from here on and display it at exit
+    if( ProfileOn) {
+        clock_gettime( CLOCK_MONOTONIC, &Profile.start);
+        atexit( displayProfile);
+    }
+
+    // Verify and benchmark once every other option, like --threads or --engine, is set
+    if( isVerify || isBenchmark) {
+        IsBatchMode = 1;
+        return runVerifyAndBenchmarks( isBenchmark) ? 0 : 1;
     }
-    printf("\n");
-} //end findAndDisplayBestSecondWords(..)
 
+    // Streaming only finds the best first and second words, which never need all the words at once
+    if( MemoryCap > 0 && (isServer || ScoreMatrixFileName != NULL
+                          || (batchMode != NULL && strcmp( batchMode, "first") != 0 && strcmp( batchMode, "second") != 0))) {
+        printf("Error: --mem-cap only works with menu options 1 and 2 or --mode first|second, without --cache\n");
+        exit(-1);
+    }
+
+    // Without the menu: load once, then run the given mode or answer queries
+    if( batchMode != NULL || isServer) {
+        IsBatchMode = 1;
+        if( ! isEngineChosen) {
+            ScoringEngine = ENGINE_AGGREGATE;   // Same scores as the default engine, in O(1) per word
+        }
+        if( MemoryCap > 0) {
+            runStreamingMode( answersFileName, guessesFileName, strcmp( batchMode, "second") == 0);
+            return 0;
+        }
+        wordCountStruct *answerWords = NULL;
+        wordCountStruct *allWords = NULL;
+        int answersWordCount = 0;
+        int totalWordCount = 0;
+        readInWordsAndDisplayNumbers( answersFileName, guessesFileName, &answerWords, &answersWordCount,
+                                      &allWords, &totalWordCount);
+        if( ScoreMatrixFileName != NULL) {
+            struct timespec phaseStart;
+            startProfilePhase( &phaseStart);
+            loadOrBuildScoreMatrix( ScoreMatrixFileName, answersFileName, guessesFileName,
+                                    answerWords, answersWordCount, allWords, totalWordCount);
+            endProfilePhase( "score matrix", &phaseStart);
+        }
+        if( isServer) {
+            runQueryServer( socketPath, answerWords, answersWordCount, allWords, totalWordCount);
+        }
+        else {
+            runBatchMode( batchMode, guesses, feedbacks, feedbackCount,
+                          answerWords, answersWordCount, allWords, totalWordCount);
+        }
+        return 0;
+    }
 
-// -----------------------------------------------------------------------------------------
-int main() {
     int answersWordCount = 0;   // Counter for number of words in answers file
-    int guessesWordCount = 0;   // Counter for number of words in answers file
-    char answersFileName[81];  // Stores the answers file name
-    char guessesFileName[81];  // Stores the guesses file name
-    // Global macros for filenames are provided at program top, for convenience in changing.
-    strcpy(answersFileName, ANSWERS_FILE_NAME);
-    strcpy(guessesFileName, GUESSES_FILE_NAME);
     printf("Default file names are %s and %s\n", answersFileName, guessesFileName);
 
     // Display menu, to allow partial credit for different program components
@@ -385,6 +4826,9 @@ int main() {
         printf("  2. Display best first and best second words\n");
         printf("  3. Change answers and guesses filenames\n");
         printf("  4. Exit\n");
+        printf("  6. Search all pairs for the best first and second words\n");
+        printf("  7. Beam search for the best sequences of opening words\n");
+        printf("  8. Interactive solver\n");
         printf("Your choice: ");
         scanf("%d", &menuOption);
 
@@ -394,7 +4838,7 @@ int main() {
         } else if( menuOption == 3) {
             // Change file names.  Menu will then be redisplayed.
             printf("Enter new answers and guesses filenames: ");
-            scanf("%s %s", answersFileName, guessesFileName);
+            scanf("%1023s %1023s", answersFileName, guessesFileName);
         } else if( menuOption == 5) {
             // Hidden menu option to choose large files
             strcpy( answersFileName, "answersLarge.txt");
@@ -405,22 +4849,58 @@ int main() {
         }
     } while( menuOption == 3);
 
-    // Count the total number of words in the answers and guesses files.
-    answersWordCount = countWordsInFile(answersFileName);
-    guessesWordCount = countWordsInFile(guessesFileName);
-    int totalWordCount = answersWordCount + guessesWordCount;
+    // With --mem-cap the words are streamed a tile at a time instead of all read in
+    if( MemoryCap > 0 && (menuOption == 1 || menuOption == 2)) {
+        runStreamingMode( answersFileName, guessesFileName, menuOption == 2);
+        printf("Done\n");
+        return 0;
+    }
+    if( MemoryCap > 0 && menuOption >= 6 && menuOption <= 8) {
+        printf("Error: --mem-cap only works with menu options 1 and 2\n");
+        exit(-1);
+    }
+
+    // Read in words from files into newly allocated arrays, displaying how many words there
+    // are in each file
+    wordCountStruct *answerWords = NULL;    // Array of the answer words
+    wordCountStruct *allWords = NULL;       // Array of all the words
+    int totalWordCount = 0;
+    readInWordsAndDisplayNumbers( answersFileName, guessesFileName, &answerWords, &answersWordCount,
+                                  &allWords, &totalWordCount);
 
-    // Allocate space for an array of answer words, and for an array of all the words.
-    wordCountStruct *answerWords = (wordCountStruct *) malloc(sizeof(wordCountStruct) * answersWordCount);
-    wordCountStruct *allWords = (wordCountStruct *) malloc(sizeof(wordCountStruct) * totalWordCount);
+    // Optionally load the precomputed scores of every guess against every answer
+    if( ScoreMatrixFileName != NULL) {
+        struct timespec phaseStart;
+        startProfilePhase( &phaseStart);
+        loadOrBuildScoreMatrix( ScoreMatrixFileName, answersFileName, guessesFileName,
+                                answerWords, answersWordCount, allWords, totalWordCount);
+        endProfilePhase( "score matrix", &phaseStart);
+    }
 
-    // Read in words from files into arrays, displaying how many words there are in each file
-    readInWordsAndDisplayNumbers(answerWords, answersWordCount, allWords, totalWordCount, guessesWordCount, answersFileName, guessesFileName);
+    // The exhaustive pair search, the beam search and the solver do their own scoring
+    if( menuOption >= 6 && menuOption <= 8) {
+        printf("\n");
+        struct timespec phaseStart;
+        startProfilePhase( &phaseStart);
+        if( menuOption == 6) {
+            findAndDisplayBestPairs( answerWords, answersWordCount, allWords, totalWordCount);
+            endProfilePhase( "pair search", &phaseStart);
+        }
+        else if( menuOption == 7) {
+            findAndDisplayBestSequences( answerWords, answersWordCount, allWords, totalWordCount);
+            endProfilePhase( "beam search", &phaseStart);
+        }
+        else {
+            runInteractiveSolver( answerWords, answersWordCount, allWords, totalWordCount);
+        }
+        printf("Done\n");
+        return 0;
+    }
 
     // For each word find its score by comparing to all answerWords.  Sort and find top scoring words.
     int numberOfTopScoringWords = 0;
     wordCountStruct *bestWords = NULL;  // Will be allocated in function below
-    findScoresAndTopWords( answerWords, answersWordCount, allWords, totalWordCount, &bestWords, &numberOfTopScoringWords);
+    findScoresAndTopWords( answerWords, NULL, answersWordCount, allWords, totalWordCount, &bestWords, &numberOfTopScoringWords);
 
     // If we got to this point, menuOption is 1 or 2
     printf("\n");
@@ -434,9 +4914,8 @@ int main() {
     else if( menuOption == 2) {
         // For each top-scoring word, find the best second word.
         printf("Words and scores for top first words and second words:\n");
-        for( int i=0; i<numberOfTopScoringWords; i++) {
-            findAndDisplayBestSecondWords( answerWords, answersWordCount, allWords, totalWordCount, bestWords, i);
-        } //end for( int i...
+        findAndDisplayAllBestSecondWords( answerWords, answersWordCount, allWords, totalWordCount,
+                                          bestWords, numberOfTopScoringWords);
     }
 
     printf("Done\n");